@@ -0,0 +1,175 @@
+/*************************************************************
+ *  affinity.c - див. affinity.h
+ *************************************************************/
+#define _GNU_SOURCE             // cpu_set_t, CPU_SET, sched_setaffinity
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <sched.h>
+
+#include "affinity.h"
+
+#ifndef CPU_SETSIZE
+#define CPU_SETSIZE 1024
+#endif
+
+static int cmp_int(const void *a, const void *b) {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static int cpu_list_append(CpuList *list, int cpu, int *capacity) {
+    if (list->count == *capacity) {
+        int new_cap = *capacity ? *capacity * 2 : 16;
+        int *tmp = realloc(list->cpus, new_cap * sizeof(int));
+        if (!tmp) return -1;
+        list->cpus = tmp;
+        *capacity = new_cap;
+    }
+    list->cpus[list->count++] = cpu;
+    return 0;
+}
+
+/*
+ * cpu_list_parse: формат ядра Linux (як у cpulist і taskset -c):
+ * числа та діапазони "a-b" через кому. Результат сортується,
+ * повтори відкидаються.
+ */
+int cpu_list_parse(const char *spec, CpuList *out) {
+    out->cpus = NULL;
+    out->count = 0;
+    int capacity = 0;
+    const char *p = spec;
+    while (*p) {
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == '\0') break;
+        if (!isdigit((unsigned char)*p)) goto bad;
+        char *end;
+        long first = strtol(p, &end, 10);
+        long last = first;
+        p = end;
+        if (*p == '-') {
+            p++;
+            if (!isdigit((unsigned char)*p)) goto bad;
+            last = strtol(p, &end, 10);
+            p = end;
+        }
+        if (last < first || last >= CPU_SETSIZE) goto bad;
+        for (long cpu = first; cpu <= last; cpu++) {
+            if (cpu_list_append(out, (int)cpu, &capacity) != 0) goto bad;
+        }
+        while (isspace((unsigned char)*p)) p++;
+        if (*p == ',') p++;
+        else if (*p != '\0') goto bad;
+    }
+
+    qsort(out->cpus, out->count, sizeof(int), cmp_int);
+    int n = 0;
+    for (int i = 0; i < out->count; i++) {
+        if (n == 0 || out->cpus[n - 1] != out->cpus[i])
+            out->cpus[n++] = out->cpus[i];
+    }
+    out->count = n;
+    return 0;
+
+bad:
+    cpu_list_free(out);
+    return -1;
+}
+
+int cpu_list_numa_node(int node, CpuList *out) {
+    char path[128];
+    char buf[4096];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+    return cpu_list_parse(buf, out);
+}
+
+void cpu_list_intersect(CpuList *a, const CpuList *b) {
+    int n = 0;
+    for (int i = 0; i < a->count; i++) {
+        if (bsearch(&a->cpus[i], b->cpus, b->count, sizeof(int), cmp_int))
+            a->cpus[n++] = a->cpus[i];
+    }
+    a->count = n;
+}
+
+void cpu_list_free(CpuList *list) {
+    free(list->cpus);
+    list->cpus = NULL;
+    list->count = 0;
+}
+
+int affinity_from_options(const char *cpu_spec, int numa_node, CpuList *out) {
+    out->cpus = NULL;
+    out->count = 0;
+    if (cpu_spec && cpu_list_parse(cpu_spec, out) != 0) {
+        fprintf(stderr, "Bad CPU list: %s\n", cpu_spec);
+        return -1;
+    }
+    if (numa_node >= 0) {
+        CpuList node;
+        if (cpu_list_numa_node(numa_node, &node) != 0) {
+            fprintf(stderr, "Cannot read CPUs of NUMA node %d\n", numa_node);
+            cpu_list_free(out);
+            return -1;
+        }
+        if (cpu_spec) {
+            cpu_list_intersect(out, &node);
+            cpu_list_free(&node);
+        } else {
+            *out = node;
+        }
+    }
+    if ((cpu_spec || numa_node >= 0) && out->count == 0) {
+        fprintf(stderr, "No CPUs left to run on\n");
+        cpu_list_free(out);
+        return -1;
+    }
+    return 0;
+}
+
+#ifdef __linux__
+// pid 0 у sched_setaffinity означає потік, що викликає
+static int pin_calling_thread(const int *cpus, int count) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int i = 0; i < count; i++)
+        CPU_SET(cpus[i], &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        perror("sched_setaffinity");
+        return -1;
+    }
+    return 0;
+}
+#else
+static int pin_calling_thread(const int *cpus, int count) {
+    (void)cpus;
+    (void)count;
+    errno = ENOSYS;
+    perror("sched_setaffinity");
+    return -1;
+}
+#endif
+
+/*
+ * affinity_pin_process: викликається з головного потоку до
+ * створення інших; нові потоки успадковують маску.
+ */
+int affinity_pin_process(const CpuList *list) {
+    if (list->count == 0) return 0;
+    return pin_calling_thread(list->cpus, list->count);
+}
+
+int affinity_pin_thread(const CpuList *list, int index) {
+    if (list->count == 0) return 0;
+    return pin_calling_thread(&list->cpus[index % list->count], 1);
+}
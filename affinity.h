@@ -0,0 +1,43 @@
+/*************************************************************
+ *  affinity.h - привʼязка процесів і потоків до ядер CPU
+ *
+ *  Спільне для воркера й дистриб'ютора: розбір списку CPU
+ *  ("0-3,8,10-11"), список CPU вузла NUMA (з sysfs) і
+ *  закріплення процесу або окремого потоку за цими CPU.
+ *  Працює лише на Linux; на інших системах функції закріплення
+ *  повертають -1.
+ *************************************************************/
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+typedef struct CpuList {
+    int *cpus;                  // Номери CPU за зростанням, без повторів
+    int count;
+} CpuList;
+
+// Розбирає "0-3,8,10-11"; повертає 0 або -1
+int cpu_list_parse(const char *spec, CpuList *out);
+
+// Список CPU вузла NUMA (/sys/devices/system/node/nodeN/cpulist)
+int cpu_list_numa_node(int node, CpuList *out);
+
+// Лишає в a лише CPU, що є і в b
+void cpu_list_intersect(CpuList *a, const CpuList *b);
+
+void cpu_list_free(CpuList *list);
+
+/*
+ * affinity_from_options: будує список із --cpu-list та/або
+ * --numa-node (обидва - перетин). Порожній результат (обидва
+ * параметри відсутні) означає "без закріплення": out->count = 0.
+ * Повертає 0 або -1 з повідомленням у stderr.
+ */
+int affinity_from_options(const char *cpu_spec, int numa_node, CpuList *out);
+
+// Закріплює весь процес (і потоки, які він створить) за списком
+int affinity_pin_process(const CpuList *list);
+
+// Закріплює потік, що викликає, за CPU list->cpus[index % count]
+int affinity_pin_thread(const CpuList *list, int index);
+
+#endif /* AFFINITY_H */
@@ -0,0 +1,376 @@
+/* Згенеровано tools/gen_common_words.py (pg1342.txt pg1513.txt pg2701.txt), не редагувати. */
+#ifndef COMMON_WORDS_H
+#define COMMON_WORDS_H
+
+#include <stdint.h>
+
+#define COMMON_WORDS_COUNT 1024
+#define COMMON_BUCKETS 256      // Степінь двійки
+#define COMMON_SLOTS 2048       // Степінь двійки
+#define COMMON_MAX_LEN 13
+
+// Зміщення d для кожного кошика (молодші біти хешу)
+static const uint16_t common_disp[COMMON_BUCKETS] = {
+    7, 0, 1, 2, 0, 0, 1, 2, 2, 1, 1, 3, 1, 2, 1, 0,
+    2, 0, 0, 1, 1, 1, 13, 0, 1, 2, 8, 0, 1, 2, 0, 0,
+    0, 1, 0, 3, 2, 1, 1, 1, 1, 6, 0, 6, 2, 2, 3, 2,
+    12, 3, 4, 3, 0, 3, 3, 2, 2, 1, 0, 1, 6, 0, 2, 2,
+    3, 0, 2, 9, 3, 0, 4, 5, 5, 1, 4, 2, 0, 4, 6, 1,
+    5, 3, 2, 16, 19, 1, 1, 0, 4, 2, 2, 1, 3, 8, 2, 1,
+    3, 8, 2, 3, 0, 3, 1, 4, 7, 10, 2, 1, 5, 2, 11, 5,
+    4, 8, 4, 1, 0, 2, 11, 1, 1, 12, 1, 2, 1, 5, 3, 1,
+    1, 0, 2, 16, 4, 11, 1, 1, 1, 2, 0, 0, 6, 2, 2, 4,
+    4, 3, 1, 0, 4, 13, 1, 2, 1, 2, 1, 7, 5, 1, 10, 0,
+    0, 0, 1, 0, 3, 0, 1, 1, 3, 0, 1, 5, 4, 2, 1, 2,
+    1, 3, 5, 1, 5, 5, 14, 6, 8, 5, 1, 1, 2, 2, 0, 1,
+    1, 1, 3, 2, 4, 1, 3, 2, 0, 3, 4, 2, 1, 2, 1, 0,
+    0, 2, 1, 9, 1, 0, 4, 6, 1, 8, 6, 2, 2, 3, 1, 2,
+    4, 0, 5, 5, 8, 1, 10, 15, 5, 0, 1, 0, 0, 8, 4, 1,
+    2, 2, 1, 7, 2, 5, 0, 1, 0, 12, 0, 1, 4, 8, 2, 5,
+};
+
+// Номер слова в комірці або -1
+static const int16_t common_slot[COMMON_SLOTS] = {
+    -1, -1, -1, -1, -1, 840, 1008, 5, 27, -1, 460, -1, 990, 310, -1, -1,
+    299, 383, 647, -1, -1, -1, -1, 653, 756, 371, -1, 895, -1, 282, -1, 485,
+    -1, 764, 6, 255, -1, 928, -1, -1, -1, -1, -1, 527, 163, -1, -1, -1,
+    690, 504, 357, 132, -1, 727, -1, 46, -1, 978, -1, -1, -1, 155, -1, -1,
+    -1, -1, -1, 159, -1, -1, 180, 624, -1, -1, -1, 260, 845, 976, 7, -1,
+    993, 980, 4, -1, 25, 681, 851, -1, 33, 430, 563, 570, -1, -1, -1, 558,
+    806, 977, 83, 998, -1, -1, -1, 468, -1, 495, -1, 81, -1, -1, 465, 377,
+    -1, -1, 127, -1, 786, -1, 708, 996, -1, 809, -1, -1, -1, 277, -1, -1,
+    -1, 142, 944, -1, -1, -1, -1, 509, -1, -1, 589, 594, -1, 124, -1, -1,
+    667, 749, -1, 474, -1, 794, -1, -1, -1, 501, -1, 846, -1, -1, -1, 438,
+    -1, -1, 324, 914, -1, 599, -1, 494, -1, 293, -1, 798, 790, 515, 314, -1,
+    103, 818, 582, -1, -1, 831, 929, -1, -1, 239, -1, 447, -1, 209, 849, -1,
+    -1, 8, -1, -1, 131, 73, -1, 1014, 679, 945, -1, -1, 271, 65, -1, 836,
+    451, -1, -1, -1, 192, -1, 176, 699, -1, -1, 551, -1, -1, -1, 242, 802,
+    229, -1, -1, 1000, 425, 214, -1, 754, -1, -1, 99, -1, -1, 722, -1, 298,
+    -1, 280, 755, 238, -1, 556, 19, -1, 586, 673, -1, -1, -1, -1, 457, -1,
+    505, -1, -1, 986, -1, -1, -1, 43, 286, 902, 266, -1, 751, 252, 703, 101,
+    -1, -1, -1, -1, 96, -1, -1, 550, 302, 428, 301, -1, 246, 557, 780, 565,
+    -1, 579, 792, 294, 810, -1, -1, -1, 961, -1, -1, 842, 516, -1, 613, -1,
+    -1, 432, -1, -1, 390, 912, -1, -1, 552, 682, 507, 991, 28, -1, 380, -1,
+    -1, 208, 865, -1, 632, 819, 152, -1, 3, 402, -1, 463, 149, -1, -1, 158,
+    -1, 549, -1, 559, 897, 906, 750, -1, 347, -1, -1, 707, 666, 382, 249, -1,
+    161, -1, 975, 503, -1, -1, -1, 620, -1, -1, 920, -1, 181, 606, -1, -1,
+    763, 1011, 154, -1, 15, 879, -1, 782, 117, 913, 169, 886, 752, -1, 332, -1,
+    -1, -1, -1, 508, -1, -1, 321, 954, 891, 964, -1, -1, 863, -1, -1, -1,
+    771, -1, -1, 304, 256, 937, -1, -1, -1, 263, -1, 471, -1, -1, -1, -1,
+    -1, -1, 148, -1, 868, 816, 542, 525, -1, -1, 949, -1, -1, 617, -1, -1,
+    513, 871, 744, -1, -1, -1, 635, -1, 531, -1, -1, 488, 283, -1, -1, -1,
+    -1, -1, 195, -1, -1, 874, 130, -1, -1, 72, -1, 140, -1, 916, 339, 640,
+    -1, 320, 409, -1, 496, 235, 305, 740, 982, -1, 992, -1, 185, 30, -1, 636,
+    876, 748, -1, 94, -1, -1, 168, -1, -1, 272, 803, -1, -1, 1001, -1, 184,
+    353, -1, -1, 783, 664, 385, -1, -1, -1, -1, -1, 389, 20, 935, 896, 698,
+    -1, 1017, 123, -1, -1, 700, 732, 361, 207, -1, 601, -1, 115, 10, 146, -1,
+    -1, -1, 778, 281, -1, 812, -1, -1, 950, 848, -1, 13, -1, 834, -1, -1,
+    53, 318, 532, 553, -1, -1, -1, 113, 927, -1, 307, 770, 56, 250, -1, 883,
+    -1, -1, -1, -1, 333, 884, -1, 807, 917, 309, -1, 987, -1, 704, -1, -1,
+    -1, 183, -1, -1, -1, -1, 172, -1, -1, 923, -1, -1, 204, 42, -1, -1,
+    841, 662, 464, 212, 936, 342, -1, -1, -1, 603, 198, -1, -1, 826, 731, -1,
+    -1, -1, 983, -1, 22, 411, -1, 772, -1, -1, -1, 240, -1, -1, 417, 670,
+    621, 948, 87, 491, -1, -1, 251, 663, 538, -1, 941, 857, -1, 334, -1, -1,
+    84, 645, 351, -1, -1, -1, -1, -1, -1, -1, -1, 892, 562, 384, -1, 253,
+    375, 329, -1, -1, -1, -1, -1, -1, -1, -1, 134, -1, 424, -1, -1, 439,
+    -1, 201, 696, 76, 931, -1, 910, -1, 89, -1, 423, -1, -1, 368, 595, -1,
+    -1, -1, 312, -1, 569, 1, 919, -1, -1, -1, 355, -1, 1013, 226, 490, -1,
+    -1, -1, 224, 278, 397, 387, -1, -1, 264, 821, 739, -1, -1, -1, 440, -1,
+    206, 52, 575, -1, -1, 363, 486, 254, -1, 330, -1, -1, -1, -1, 880, -1,
+    -1, 758, 909, -1, -1, -1, -1, 867, -1, -1, 23, -1, -1, 564, 259, 410,
+    -1, 480, -1, -1, 634, 602, 262, 627, 369, -1, 833, -1, 677, 416, -1, -1,
+    -1, -1, 672, 567, -1, -1, -1, 61, 1022, 972, 381, 967, -1, 285, 933, -1,
+    421, -1, -1, 930, -1, -1, -1, -1, 188, 156, -1, 587, -1, 497, -1, 454,
+    193, -1, -1, -1, -1, 473, -1, -1, -1, -1, -1, 850, 211, 506, -1, -1,
+    956, 922, 719, -1, 725, -1, 267, -1, -1, -1, -1, 773, -1, 687, -1, 604,
+    -1, 524, -1, 9, -1, 1002, -1, -1, -1, 399, 546, -1, 456, -1, 395, 591,
+    -1, -1, 362, -1, 899, -1, 287, 100, -1, -1, 316, -1, -1, 95, 187, -1,
+    -1, -1, -1, -1, 426, 483, -1, 448, 736, 179, 765, 297, 626, 476, -1, -1,
+    -1, 890, -1, -1, -1, 768, 378, 500, 759, -1, -1, 241, 16, -1, 796, 144,
+    799, 458, -1, -1, -1, 125, 360, -1, -1, -1, 631, -1, 907, -1, 441, 317,
+    328, -1, -1, -1, -1, -1, -1, 279, 678, -1, 284, -1, -1, -1, -1, 577,
+    -1, -1, -1, 54, 974, 611, -1, 112, 844, -1, -1, 781, -1, 121, -1, -1,
+    -1, -1, 526, 79, 934, -1, -1, -1, -1, 354, -1, 292, 979, 966, 518, -1,
+    66, -1, -1, 200, 864, -1, -1, 638, -1, -1, -1, -1, 903, -1, -1, -1,
+    -1, 481, -1, -1, 644, -1, -1, 942, -1, -1, -1, -1, -1, -1, 336, 167,
+    1003, -1, -1, 128, 408, -1, 694, -1, -1, 777, -1, 711, 137, -1, 475, -1,
+    -1, 971, -1, 787, -1, 658, 622, -1, 492, -1, -1, -1, -1, 544, -1, 767,
+    689, -1, 415, -1, -1, 219, 1005, 215, 218, -1, 37, 597, 35, 734, 574, -1,
+    926, -1, -1, -1, -1, -1, 540, -1, 80, 70, 793, 107, -1, 323, -1, -1,
+    105, -1, 102, 374, 881, 222, 393, 970, -1, -1, 633, 637, -1, 403, 958, -1,
+    313, 446, -1, 391, -1, 968, 738, 431, 2, -1, -1, 523, -1, -1, -1, -1,
+    898, -1, -1, 145, -1, 1015, 648, -1, -1, -1, -1, 808, 443, -1, -1, -1,
+    -1, 828, 534, 817, -1, 17, -1, -1, 34, 661, 78, -1, -1, 714, 584, 203,
+    843, -1, 392, -1, 820, -1, 450, 882, 388, -1, 650, -1, 737, 730, -1, -1,
+    825, -1, 136, 367, -1, 398, -1, -1, 669, 290, -1, -1, -1, -1, -1, 963,
+    830, -1, 108, -1, 376, 418, -1, 969, 346, -1, -1, -1, -1, -1, 576, 138,
+    -1, 757, 536, 472, -1, -1, 628, -1, -1, 560, -1, -1, -1, 340, -1, -1,
+    -1, 68, -1, 60, -1, -1, 660, 753, -1, -1, 554, 997, 955, -1, -1, 774,
+    724, 573, -1, -1, -1, -1, 959, -1, -1, 171, -1, 77, 106, -1, -1, -1,
+    539, -1, 795, 872, 566, -1, -1, -1, -1, 359, 535, -1, 852, -1, -1, -1,
+    -1, 943, -1, 433, -1, -1, -1, 1018, 915, 784, -1, -1, -1, -1, 325, 315,
+    -1, -1, 543, -1, -1, -1, -1, -1, -1, -1, 406, -1, -1, -1, 202, 24,
+    133, -1, 437, 887, -1, 723, 275, -1, 178, -1, -1, -1, 165, 709, 337, -1,
+    692, -1, -1, -1, -1, -1, -1, 14, 274, 908, 824, -1, -1, -1, 776, 93,
+    300, 221, 853, -1, -1, -1, -1, -1, 237, 119, 265, -1, -1, -1, 499, -1,
+    -1, -1, -1, -1, 530, 162, 343, -1, -1, 234, -1, 994, 36, 444, 999, -1,
+    -1, 449, 261, -1, 861, -1, 205, -1, 630, 680, 545, 814, 878, -1, 745, -1,
+    -1, -1, 718, 691, 801, -1, 1010, -1, 379, 59, -1, 74, 47, -1, 467, -1,
+    -1, -1, -1, -1, 413, -1, -1, 607, 210, -1, 135, -1, -1, 365, 643, -1,
+    -1, 196, -1, 29, 49, -1, -1, 232, 227, 1021, 614, 244, 288, 111, 973, 358,
+    -1, -1, 422, 676, -1, 120, 651, 965, 1023, -1, 0, -1, 326, 466, -1, 116,
+    -1, 427, 608, -1, 51, -1, -1, -1, -1, -1, -1, 747, 625, -1, 55, 596,
+    197, -1, -1, -1, -1, 904, 139, -1, 797, 733, -1, -1, 370, 612, 191, 153,
+    547, -1, 114, 668, -1, -1, -1, 583, 189, 331, 349, 160, 50, 721, -1, 41,
+    -1, 706, 813, -1, -1, -1, 230, 493, 414, -1, 477, 789, -1, 405, -1, 938,
+    -1, -1, 308, 273, 866, -1, -1, 236, -1, -1, -1, -1, -1, 86, -1, 800,
+    489, -1, -1, -1, -1, 306, 588, 407, -1, -1, 419, 170, 720, 45, -1, 746,
+    655, -1, -1, -1, 932, -1, -1, -1, 322, -1, 674, -1, -1, -1, -1, 173,
+    -1, -1, 766, 62, 697, -1, 40, -1, 717, 412, 190, -1, -1, 561, 88, 568,
+    303, 58, -1, 837, -1, 373, 482, 788, 364, -1, -1, 988, 619, 735, 688, 779,
+    641, 901, 31, 186, -1, 104, -1, 529, -1, 122, -1, -1, 11, 946, 98, 835,
+    519, 580, 952, 248, -1, 194, -1, -1, 348, 512, 877, 742, -1, -1, -1, 947,
+    -1, 296, 258, -1, 327, -1, -1, 860, 1006, 829, 511, 469, 522, -1, 925, -1,
+    514, -1, -1, -1, -1, -1, -1, -1, 939, 143, -1, -1, 18, 396, 713, -1,
+    585, 639, 600, -1, -1, -1, -1, -1, -1, 960, -1, 67, -1, 838, 981, 141,
+    -1, -1, 953, -1, -1, -1, 827, 461, -1, -1, 815, 257, 442, 760, 268, -1,
+    -1, -1, 712, -1, -1, -1, 352, 548, 247, -1, -1, -1, -1, -1, -1, -1,
+    572, 924, 174, 592, -1, 166, 356, -1, 38, -1, -1, -1, 39, 295, 64, -1,
+    -1, -1, 366, 775, -1, -1, 164, 811, 743, -1, -1, -1, 791, -1, -1, 832,
+    -1, 92, -1, -1, -1, 510, 581, 150, 578, 57, -1, -1, 85, -1, -1, -1,
+    -1, 32, -1, 436, 269, 642, 989, -1, -1, -1, 856, -1, 804, 533, -1, -1,
+    -1, 82, 716, -1, 245, 656, 462, 854, 785, -1, -1, -1, 319, -1, -1, -1,
+    -1, 671, -1, 957, 659, -1, -1, 445, 684, 243, -1, -1, -1, 228, 665, 429,
+    -1, 805, 889, 470, 555, -1, 182, -1, 823, -1, 654, 858, -1, 453, 21, 345,
+    -1, -1, 213, 157, 894, -1, 12, -1, -1, -1, 109, 311, -1, -1, 97, -1,
+    118, -1, 498, -1, 26, -1, -1, 761, -1, -1, -1, 726, 484, -1, 859, -1,
+    -1, 270, 217, -1, -1, 435, 873, 862, 1004, 502, 900, 528, 289, -1, -1, -1,
+    147, 63, 571, -1, 921, 1009, -1, 616, -1, 48, -1, -1, 1019, -1, 893, 175,
+    715, 220, -1, -1, -1, -1, -1, -1, 762, 44, -1, -1, 521, -1, -1, -1,
+    478, 335, 338, 291, -1, -1, -1, 199, -1, -1, -1, -1, -1, 151, 646, 885,
+    -1, -1, 618, 649, -1, -1, 90, -1, 686, 675, -1, 984, -1, 487, 590, -1,
+    520, -1, -1, -1, -1, -1, -1, -1, -1, -1, 605, -1, 276, 177, 71, -1,
+    593, 129, 434, -1, 911, 693, 918, -1, -1, 233, -1, 452, 685, -1, 344, 610,
+    -1, -1, -1, 91, -1, 1016, -1, -1, 995, 404, -1, -1, 769, 695, 615, -1,
+    728, -1, -1, 350, -1, -1, 110, -1, -1, 459, -1, -1, -1, 962, 710, -1,
+    705, 394, -1, -1, -1, -1, -1, 225, 541, -1, 420, 629, -1, 839, -1, 400,
+    741, -1, 822, 940, 386, -1, -1, -1, 69, 869, 701, 1020, -1, -1, 401, -1,
+    951, -1, -1, -1, 216, -1, -1, -1, -1, -1, -1, 847, 888, 372, 623, 517,
+    341, -1, -1, -1, -1, 126, 855, 537, -1, -1, -1, -1, -1, -1, -1, -1,
+    223, 985, -1, 479, -1, -1, 875, 683, 1007, 905, 870, -1, 455, -1, -1, 75,
+    -1, -1, 702, -1, -1, 598, 657, 652, -1, 1012, -1, 231, -1, -1, 729, 609,
+};
+
+// Слова за спаданням частоти
+static const char common_words[COMMON_WORDS_COUNT][COMMON_MAX_LEN + 1] = {
+    "the", "of", "and", "to", "a", "in", "that", "i", "it", "his", "was",
+    "he", "with", "as", "is", "but", "for", "not", "s", "you", "her", "be",
+    "all", "at", "this", "by", "she", "had", "him", "on", "so", "have",
+    "from", "my", "me", "or", "they", "there", "which", "were", "what",
+    "one", "whale", "no", "their", "are", "now", "an", "when", "if", "will",
+    "would", "been", "them", "more", "some", "then", "mr", "very", "your",
+    "such", "we", "do", "like", "could", "man", "out", "any", "said",
+    "other", "who", "up", "upon", "into", "must", "than", "elizabeth",
+    "though", "only", "much", "did", "time", "how", "before", "has", "thou",
+    "may", "these", "can", "well", "ship", "ahab", "most", "good", "its",
+    "over", "old", "should", "here", "ye", "am", "after", "down", "about",
+    "again", "long", "see", "yet", "great", "sea", "two", "say", "little",
+    "never", "know", "being", "first", "darcy", "every", "own", "last",
+    "still", "way", "head", "chapter", "might", "us", "those", "too",
+    "where", "day", "go", "shall", "come", "without", "mrs", "think",
+    "soon", "our", "ever", "seemed", "himself", "bennet", "boat", "away",
+    "while", "captain", "made", "make", "t", "lady", "d", "romeo", "miss",
+    "three", "nothing", "men", "sir", "bingley", "many", "same", "even",
+    "jane", "look", "gutenberg", "off", "through", "white", "let", "thy",
+    "love", "world", "give", "whales", "side", "project", "thought",
+    "almost", "hand", "thee", "round", "stubb", "life", "night", "take",
+    "queequeg", "herself", "oh", "seen", "nor", "tell", "cried", "part",
+    "sperm", "till", "back", "eyes", "came", "young", "however", "far",
+    "thing", "saw", "work", "o", "both", "sister", "once", "whole", "room",
+    "cannot", "place", "right", "half", "why", "ll", "always", "something",
+    "against", "deck", "wickham", "dear", "heard", "starbuck", "among",
+    "each", "indeed", "found", "just", "water", "enough", "juliet", "does",
+    "full", "between", "god", "collins", "sort", "towards", "another",
+    "father", "house", "things", "myself", "air", "perhaps", "under",
+    "fish", "pequod", "done", "lydia", "moment", "thus", "better", "death",
+    "poor", "heart", "mother", "because", "few", "line", "often", "went",
+    "having", "family", "hope", "illustration", "therefore", "called",
+    "capulet", "morning", "hear", "whose", "get", "small", "word", "friend",
+    "sure", "aye", "present", "certain", "gone", "yes", "going", "nurse",
+    "years", "speak", "hands", "new", "whether", "felt", "least", "dead",
+    "letter", "boats", "don", "mind", "end", "true", "face", "within",
+    "stand", "crew", "find", "known", "less", "looked", "quite", "set",
+    "times", "whom", "rather", "left", "days", "manner", "next", "since",
+    "anything", "general", "high", "whaling", "also", "catherine", "name",
+    "mast", "sight", "together", "works", "feet", "home", "sometimes",
+    "light", "point", "hold", "put", "along", "best", "eye", "reason",
+    "matter", "believe", "body", "business", "means", "really", "told",
+    "wish", "coming", "sun", "keep", "seems", "case", "near", "either",
+    "began", "four", "ill", "replied", "strange", "short", "others", "st",
+    "subject", "flask", "length", "rest", "took", "bed", "lord", "town",
+    "turned", "use", "second", "seem", "black", "call", "friar", "help",
+    "kind", "certainly", "looking", "people", "enter", "feel", "knew",
+    "large", "open", "sail", "stood", "art", "daughter", "happy", "passed",
+    "pleasure", "voyage", "arm", "e", "else", "ere", "live", "living",
+    "received", "hard", "itself", "ladies", "wild", "answer", "course",
+    "fair", "terms", "turn", "comes", "gardiner", "given", "seeing", "soul",
+    "added", "brother", "feelings", "fine", "lizzy", "nantucket", "gave",
+    "leviathan", "scene", "wife", "copyright", "hour", "lay", "leave",
+    "standing", "person", "evening", "fire", "forth", "heads", "leg",
+    "themselves", "aunt", "further", "heaven", "iron", "thousand", "book",
+    "above", "oil", "possible", "alone", "dick", "mine", "moby",
+    "gentlemen", "longbourn", "mercutio", "read", "ships", "watch", "cabin",
+    "charlotte", "object", "seas", "door", "instant", "jonah", "suppose",
+    "taken", "de", "five", "making", "power", "idea", "particular",
+    "character", "deep", "hardly", "sat", "stay", "tail", "want", "beneath",
+    "foundation", "lawrence", "married", "ten", "country", "electronic",
+    "everything", "forward", "harpooneer", "land", "mean", "ocean",
+    "opinion", "sailor", "blood", "immediately", "lost", "marriage",
+    "tybalt", "yourself", "attention", "benvolio", "boy", "brought", "mate",
+    "return", "run", "used", "whatever", "woman", "doubt", "form", "hours",
+    "sisters", "bildad", "friends", "nature", "vast", "voice", "account",
+    "ground", "happiness", "harpoon", "saying", "several", "uncle", "board",
+    "common", "order", "table", "taking", "wind", "bear", "cousin", "fast",
+    "gentleman", "got", "king", "pip", "london", "netherfield", "peleg",
+    "talk", "wonder", "especially", "fear", "kitty", "party", "top",
+    "whalemen", "close", "law", "lucas", "says", "state", "view", "hath",
+    "lower", "marry", "tis", "already", "husband", "none", "pride", "try",
+    "visit", "waters", "chance", "colonel", "conversation", "except",
+    "fellow", "sweet", "turning", "dark", "different", "earth", "easy",
+    "feeling", "longer", "mark", "purpose", "ready", "truth", "words",
+    "affection", "behind", "continued", "sense", "spoke", "story",
+    "suddenly", "able", "acquaintance", "ago", "fishery", "kept", "met",
+    "mouth", "natural", "peculiar", "struck", "unless", "below",
+    "impossible", "noble", "states", "thoughts", "aloft", "broad", "chase",
+    "makes", "master", "twenty", "walk", "company", "green", "late",
+    "paris", "son", "sound", "stranger", "besides", "beyond", "curious",
+    "during", "fact", "hundred", "meet", "settled", "sleep", "spout",
+    "sudden", "united", "bow", "fixed", "following", "goes", "hence",
+    "rope", "year", "creature", "dare", "devil", "early", "former", "nay",
+    "perfectly", "play", "pretty", "regard", "returned", "strong", "bottom",
+    "cook", "engaged", "jaw", "minutes", "news", "quarter", "afterwards",
+    "agreement", "bones", "broken", "cold", "cut", "daughters", "die",
+    "entirely", "free", "george", "grand", "hast", "indian", "leaving",
+    "meryton", "neither", "real", "remained", "savage", "slowly",
+    "tashtego", "answered", "asked", "behaviour", "care", "caught",
+    "consider", "distance", "drawing", "exactly", "girls", "giving",
+    "harpooneers", "ivory", "license", "main", "plain", "running",
+    "speaking", "straight", "wide", "english", "entire", "ought", "parts",
+    "pemberley", "vessel", "chief", "circumstances", "craft", "entered",
+    "girl", "instantly", "merely", "proper", "question", "scarcely", "self",
+    "send", "single", "stern", "afraid", "bone", "cause", "coffin",
+    "information", "officers", "silence", "vain", "wholly", "act", "dinner",
+    "kill", "pass", "quick", "respect", "sailors", "show", "silent",
+    "teeth", "walked", "william", "bows", "carpenter", "clear",
+    "concerning", "followed", "heavy", "low", "manners", "nearly",
+    "occasion", "pray", "sharks", "thinking", "agreeable", "ball", "degree",
+    "delight", "expected", "fortune", "glad", "lie", "mary", "monster",
+    "nevertheless", "spirits", "understand", "ask", "beauty", "calm",
+    "deal", "mere", "miles", "money", "pull", "rosings", "servant", "blue",
+    "bring", "carriage", "child", "comfort", "generally", "interest",
+    "looks", "mad", "pleased", "waves", "assure", "brow", "circumstance",
+    "doth", "everybody", "honour", "lines", "mighty", "montague", "need",
+    "prince", "remember", "sharp", "surprise", "talking", "touching",
+    "various", "children", "directly", "fall", "ho", "mentioned",
+    "observed", "placed", "plainly", "sails", "sake", "somehow", "supper",
+    "whaleman", "write", "written", "bound", "civility", "considering",
+    "donations", "equal", "fancy", "gold", "hole", "instead", "lance",
+    "lips", "mention", "mortal", "paid", "satisfied", "sitting", "spite",
+    "start", "unknown", "wake", "woe", "ah", "appearance", "ay", "born",
+    "convinced", "cry", "doing", "drew", "fresh", "held", "likely", "meant",
+    "middle", "nigh", "particularly", "queer", "red", "resolved", "rose",
+    "talked", "third", "age", "appear", "aspect", "believed", "breakfast",
+    "copy", "dance", "exceedingly", "foot", "grave", "ha", "hat", "human",
+    "joy", "knowing", "ladyship", "madam", "otherwise", "receive", "rolled",
+    "seamen", "sent", "situation", "six", "stop", "street", "usual",
+    "wondrous", "wood", "appeared", "brain", "coast", "considerable",
+    "countenance", "em", "f", "follow", "greater", "happened", "holy",
+    "notice", "number", "pipe", "previous", "repeated", "seated", "society",
+    "sorry", "spring", "strike", "supposed", "surface", "trademark",
+    "whenever", "wished", "bourgh", "change", "charge", "conduct",
+    "cutting", "handsome", "hearing", "hertfordshire", "knows", "likewise",
+    "loose", "mass", "mates", "probably", "ran", "sensible", "steady",
+    "weather", "anybody", "archive", "around", "became", "cape",
+    "completely", "consequence", "determined", "duty", "holding", "lies",
+    "literary", "lives", "shot", "steelkilt", "surprised", "turns",
+    "advantage", "anyone", "arms", "aside", "boys", "easily", "ebook",
+    "expect", "fell", "fifty", "forced", "forecastle", "forehead",
+    "forster", "forty", "future", "heading", "killed", "latter", "laugh",
+    "match", "necessary", "oars", "peter", "please", "step", "wilt",
+    "women", "worse", "allow", "ancient", "bad", "bulwarks", "carried",
+    "considered", "darted", "formed", "frequently", "legs", "m", "marked",
+    "meeting", "months", "morrow", "opportunity", "possibly", "reached",
+    "remain", "rising", "sailed", "sign", "sit", "smile", "summer", "touch",
+    "won", "across", "affair", "allen", "altogether", "arrival", "become",
+    "creatures", "daggoo", "dost", "drawn", "eight", "famous",
+    "fitzwilliam", "flukes",
+};
+
+static const uint8_t common_len[COMMON_WORDS_COUNT] = {
+    3, 2, 3, 2, 1, 2, 4, 1, 2, 3, 3, 2, 4, 2, 2, 3,
+    3, 3, 1, 3, 3, 2, 3, 2, 4, 2, 3, 3, 3, 2, 2, 4,
+    4, 2, 2, 2, 4, 5, 5, 4, 4, 3, 5, 2, 5, 3, 3, 2,
+    4, 2, 4, 5, 4, 4, 4, 4, 4, 2, 4, 4, 4, 2, 2, 4,
+    5, 3, 3, 3, 4, 5, 3, 2, 4, 4, 4, 4, 9, 6, 4, 4,
+    3, 4, 3, 6, 3, 4, 3, 5, 3, 4, 4, 4, 4, 4, 3, 4,
+    3, 6, 4, 2, 2, 5, 4, 5, 5, 4, 3, 3, 5, 3, 3, 3,
+    6, 5, 4, 5, 5, 5, 5, 3, 4, 5, 3, 4, 7, 5, 2, 5,
+    3, 5, 3, 2, 5, 4, 7, 3, 5, 4, 3, 4, 6, 7, 6, 4,
+    4, 5, 7, 4, 4, 1, 4, 1, 5, 4, 5, 7, 3, 3, 7, 4,
+    4, 4, 4, 4, 9, 3, 7, 5, 3, 3, 4, 5, 4, 6, 4, 7,
+    7, 6, 4, 4, 5, 5, 4, 5, 4, 8, 7, 2, 4, 3, 4, 5,
+    4, 5, 4, 4, 4, 4, 5, 7, 3, 5, 3, 4, 1, 4, 6, 4,
+    5, 4, 6, 5, 5, 4, 3, 2, 6, 9, 7, 4, 7, 4, 5, 8,
+    5, 4, 6, 5, 4, 5, 6, 6, 4, 4, 7, 3, 7, 4, 7, 7,
+    6, 5, 6, 6, 3, 7, 5, 4, 6, 4, 5, 6, 4, 6, 5, 4,
+    5, 6, 7, 3, 4, 5, 4, 6, 6, 4, 12, 9, 6, 7, 7, 4,
+    5, 3, 5, 4, 6, 4, 3, 7, 7, 4, 3, 5, 5, 5, 5, 5,
+    3, 7, 4, 5, 4, 6, 5, 3, 4, 3, 4, 4, 6, 5, 4, 4,
+    5, 4, 6, 5, 3, 5, 4, 6, 4, 4, 6, 4, 5, 8, 7, 4,
+    7, 4, 9, 4, 4, 5, 8, 5, 4, 4, 9, 5, 5, 4, 3, 5,
+    4, 3, 6, 6, 7, 4, 8, 5, 6, 4, 4, 6, 3, 4, 5, 4,
+    4, 6, 5, 4, 3, 7, 7, 5, 6, 2, 7, 5, 6, 4, 4, 3,
+    4, 4, 6, 3, 6, 4, 5, 4, 5, 4, 4, 9, 7, 6, 5, 4,
+    4, 5, 4, 4, 5, 3, 8, 5, 6, 8, 6, 3, 1, 4, 3, 4,
+    6, 8, 4, 6, 6, 4, 6, 6, 4, 5, 4, 5, 8, 5, 6, 4,
+    5, 7, 8, 4, 5, 9, 4, 9, 5, 4, 9, 4, 3, 5, 8, 6,
+    7, 4, 5, 5, 3, 10, 4, 7, 6, 4, 8, 4, 5, 3, 8, 5,
+    4, 4, 4, 9, 9, 8, 4, 5, 5, 5, 9, 6, 4, 4, 7, 5,
+    7, 5, 2, 4, 6, 5, 4, 10, 9, 4, 6, 3, 4, 4, 4, 7,
+    10, 8, 7, 3, 7, 10, 10, 7, 10, 4, 4, 5, 7, 6, 5, 11,
+    4, 8, 6, 8, 9, 8, 3, 7, 4, 6, 3, 4, 8, 5, 5, 4,
+    5, 7, 6, 7, 6, 4, 5, 7, 6, 9, 7, 6, 7, 5, 5, 6,
+    5, 5, 6, 4, 4, 6, 4, 9, 3, 4, 3, 6, 11, 5, 4, 6,
+    10, 4, 5, 5, 3, 8, 5, 3, 5, 4, 5, 4, 4, 5, 5, 3,
+    7, 7, 4, 5, 3, 5, 6, 6, 7, 12, 6, 6, 5, 7, 4, 9,
+    5, 4, 7, 6, 4, 7, 5, 5, 5, 9, 6, 9, 5, 5, 5, 8,
+    4, 12, 3, 7, 4, 3, 5, 7, 8, 6, 6, 5, 10, 5, 6, 8,
+    5, 5, 5, 5, 6, 6, 4, 7, 5, 4, 5, 3, 5, 8, 7, 6,
+    7, 6, 4, 7, 4, 7, 5, 5, 6, 6, 3, 5, 9, 4, 5, 4,
+    4, 8, 4, 5, 5, 6, 3, 9, 4, 6, 6, 8, 6, 6, 4, 7,
+    3, 7, 4, 7, 10, 9, 5, 6, 4, 3, 9, 3, 8, 4, 6, 5,
+    4, 6, 7, 7, 7, 4, 8, 6, 6, 8, 8, 5, 9, 4, 6, 8,
+    8, 7, 7, 5, 6, 11, 5, 7, 4, 5, 7, 8, 8, 4, 7, 6,
+    5, 5, 9, 6, 5, 13, 5, 7, 4, 9, 6, 6, 8, 8, 4, 4,
+    6, 5, 6, 4, 5, 6, 11, 8, 7, 4, 6, 3, 6, 4, 4, 5,
+    7, 7, 4, 6, 5, 6, 7, 4, 9, 5, 10, 8, 5, 3, 7, 6,
+    8, 4, 6, 8, 9, 4, 6, 7, 8, 7, 4, 3, 4, 7, 12, 7,
+    10, 3, 6, 4, 4, 4, 5, 5, 4, 7, 7, 4, 5, 8, 5, 7,
+    9, 8, 5, 3, 7, 5, 6, 4, 12, 4, 9, 6, 5, 6, 8, 4,
+    6, 8, 5, 8, 7, 8, 7, 8, 8, 4, 2, 9, 8, 6, 7, 5,
+    4, 7, 6, 8, 5, 7, 5, 8, 11, 9, 5, 5, 4, 4, 7, 5,
+    4, 7, 6, 4, 9, 7, 5, 5, 7, 4, 3, 2, 10, 2, 4, 9,
+    3, 5, 4, 5, 4, 6, 5, 6, 4, 12, 5, 3, 8, 4, 6, 5,
+    3, 6, 6, 8, 9, 4, 5, 11, 4, 5, 2, 3, 5, 3, 7, 8,
+    5, 9, 7, 6, 6, 4, 9, 3, 4, 6, 5, 8, 4, 8, 5, 5,
+    12, 11, 2, 1, 6, 7, 8, 4, 6, 6, 4, 8, 8, 6, 7, 5,
+    6, 6, 8, 7, 9, 8, 6, 6, 6, 6, 7, 7, 8, 7, 13, 5,
+    8, 5, 4, 5, 8, 3, 8, 6, 7, 7, 7, 6, 6, 4, 10, 11,
+    10, 4, 7, 4, 8, 5, 4, 9, 9, 5, 9, 6, 4, 5, 4, 6,
+    5, 6, 4, 5, 6, 10, 8, 7, 5, 6, 7, 6, 6, 5, 5, 9,
+    4, 5, 6, 4, 4, 5, 5, 5, 7, 3, 8, 7, 10, 6, 6, 10,
+    4, 1, 6, 7, 6, 6, 11, 8, 7, 6, 6, 6, 4, 3, 5, 6,
+    5, 3, 6, 6, 5, 10, 7, 6, 9, 6, 4, 5, 5, 6, 11, 6,
+};
+
+#endif /* COMMON_WORDS_H */
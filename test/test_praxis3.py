@@ -3,6 +3,10 @@ Tests for RN Praxis 3
 """
 
 import multiprocessing
+import os
+import random
+import re
+from collections import Counter
 from sys import stderr
 
 import numpy as np
@@ -263,6 +267,592 @@ def test_book_2(program_args):
         assert distributor_output == correct_word_count, f"{num_workers} workers failed book 2 test."
 
 
+@pytest.mark.timeout(90)
+def test_stdin(program_args):
+    filename = test_args["filename_book_1"]
+    base_port = test_args["base_port"]
+    book_text = test_args["books"][0]
+
+    file_out = open(filename, "wb")
+    file_out.write(book_text)
+    file_out.close()
+
+    book_text_str = book_text.decode("ascii", errors="ignore")
+    correct_word_count = util.count_words(book_text_str)
+
+    workers = np.arange(base_port, base_port + 2).tolist()
+    port_list = [str(x) for x in workers]
+
+    # the same book from the file path, from "-" and from --stdin via a pipe
+    outputs = []
+    for source in [[filename], ["-"], ["--stdin"]]:
+        # kill any zmq procs currently running
+        util.kill_zmq_distributor_and_worker()
+
+        worker_procs = util.start_threaded_workers(test_args["worker"], port_list)
+        piped = source[0] != filename
+        proc_distributor = util.start_distributor([test_args["distributor"]] + source + port_list,
+                                                  stdin=subprocess.PIPE if piped else None)
+
+        distributor_output, distributor_err = proc_distributor.communicate(book_text_str if piped else None)
+        util.join_workers(worker_procs)
+        outputs.append(distributor_output)
+
+        if debug_tests:
+            util.create_test_debug_output("test_stdin_" + source[0].strip("-"), 2, correct_word_count, distributor_output)
+
+    assert outputs[0] == correct_word_count, "Distributor failed book 1 test from the file path."
+    assert outputs[1] == outputs[0], "Reading the book from \"-\" gave a different result than the file path."
+    assert outputs[2] == outputs[0], "Reading the book with --stdin gave a different result than the file path."
+
+
+@pytest.mark.timeout(60)
+def test_checkpoint_resume(program_args):
+    filename = test_args["filename_book_1"]
+    checkpoint = test_args["filename_checkpoint"]
+    base_port = test_args["base_port"]
+    book_text = test_args["books"][0]
+
+    file_out = open(filename, "wb")
+    file_out.write(book_text)
+    file_out.close()
+    if os.path.isfile(checkpoint):
+        os.remove(checkpoint)
+
+    # kill any zmq procs currently running
+    util.kill_zmq_distributor_and_worker()
+
+    # python worker answers some map requests and then stalls,
+    # the distributor is killed once it has written a checkpoint
+    context = zmq.Context.instance()
+    socket = context.socket(zmq.REP)
+    socket.setsockopt(zmq.LINGER, 0)
+    socket.bind("tcp://*:" + str(base_port))
+
+    proc_distributor = util.start_distributor([test_args["distributor"], "--checkpoint", checkpoint,
+                                               "--checkpoint-interval", "1", filename, str(base_port)])
+    for i in range(50):
+        msg = socket.recv()
+        assert msg[0:3] == b"map", "Distributor sent a non-map request during the map phase."
+        socket.send(util.map_reply(msg[3:].rstrip(b"\0").decode("ascii")).encode("ascii"))
+
+    for i in range(50):
+        if os.path.isfile(checkpoint):
+            break
+        time.sleep(0.1)
+    proc_distributor.kill()
+    proc_distributor.communicate()
+    socket.close()
+
+    assert os.path.isfile(checkpoint), "Distributor did not write a checkpoint."
+
+    port_list = [str(base_port), str(base_port + 1)]
+
+    # a checkpoint of a different job must be rejected
+    util.kill_zmq_distributor_and_worker()
+    worker_procs = util.start_threaded_workers(test_args["worker"], port_list)
+    proc_distributor = util.start_distributor([test_args["distributor"], "--checkpoint", checkpoint, "--resume",
+                                               "--min-len", "3", filename] + port_list)
+    distributor_output, distributor_err = proc_distributor.communicate()
+    util.kill_zmq_distributor_and_worker()
+    util.join_workers(worker_procs)
+
+    assert proc_distributor.returncode != 0, "Distributor resumed from a checkpoint of a different job."
+    assert distributor_output == "", "Distributor printed counts for a rejected checkpoint."
+
+    # the same job resumes to exact counts
+    worker_procs = util.start_threaded_workers(test_args["worker"], port_list)
+    proc_distributor = util.start_distributor([test_args["distributor"], "--checkpoint", checkpoint, "--resume",
+                                               filename] + port_list)
+    util.join_workers(worker_procs)
+    distributor_output, distributor_err = proc_distributor.communicate()
+
+    book_text_str = book_text.decode("ascii", errors="ignore")
+    correct_word_count = util.count_words(book_text_str)
+
+    if debug_tests:
+        util.create_test_debug_output("test_checkpoint_resume", 2, correct_word_count, distributor_output)
+
+    assert distributor_output == correct_word_count, "Distributor failed to resume book 1 from a checkpoint."
+    assert not os.path.isfile(checkpoint), "Distributor kept the checkpoint of a finished job."
+
+
+@pytest.mark.timeout(90)
+def test_cache(program_args):
+    filename = test_args["filename_book_1"]
+    cache = test_args["filename_cache"]
+    base_port = test_args["base_port"]
+    book_text = test_args["books"][0]
+
+    file_out = open(filename, "wb")
+    file_out.write(book_text)
+    file_out.close()
+    if os.path.isfile(cache):
+        os.remove(cache)
+
+    book_text_str = book_text.decode("ascii", errors="ignore")
+    correct_word_count = util.count_words(book_text_str)
+    # --min-len 3 drops the shorter words and keeps the order of the rest
+    lines = correct_word_count.splitlines(keepends=True)
+    filtered_word_count = lines[0] + "".join(l for l in lines[1:] if len(l.split(",")[0]) >= 3)
+
+    workers = np.arange(base_port, base_port + 2).tolist()
+    port_list = [str(x) for x in workers]
+
+    # first run fills the cache, second reuses every chunk, changed filters must not
+    runs = [([], correct_word_count, "0 hits"),
+            ([], correct_word_count, "0 misses"),
+            (["--min-len", "3"], filtered_word_count, "0 hits")]
+    for i, (options, expected, cache_stats) in enumerate(runs):
+        # kill any zmq procs currently running
+        util.kill_zmq_distributor_and_worker()
+
+        worker_procs = util.start_threaded_workers(test_args["worker"], port_list)
+        proc_distributor = util.start_distributor([test_args["distributor"], "--cache", cache] + options +
+                                                  [filename] + port_list, stderr=subprocess.PIPE)
+
+        util.join_workers(worker_procs)
+        distributor_output, distributor_err = proc_distributor.communicate()
+
+        if debug_tests:
+            util.create_test_debug_output("test_cache_run=" + str(i + 1), 2, expected, distributor_output)
+
+        assert distributor_output == expected, f"Distributor failed book 1 test in cache run {i + 1}."
+        assert cache_stats in distributor_err, f"Expected \"{cache_stats}\" in cache run {i + 1}: {distributor_err}"
+
+    os.remove(cache)
+
+
+@pytest.mark.timeout(90)
+def test_ngram(program_args):
+    filename = test_args["filename_book_1"]
+    base_port = test_args["base_port"]
+    book_text = test_args["books"][0]
+
+    file_out = open(filename, "wb")
+    file_out.write(book_text)
+    file_out.close()
+
+    book_text_str = book_text.decode("ascii", errors="ignore")
+
+    # n-grams that cross chunk borders come from the context of the previous chunk
+    for n in [2, 3]:
+        correct_ngram_count = util.count_ngrams(book_text_str, n)
+
+        for options in [[], ["--normalize"]]:
+            num_workers = 4
+            workers = np.arange(base_port, base_port + num_workers).tolist()
+            port_list = [str(x) for x in workers]
+
+            # kill any zmq procs currently running
+            util.kill_zmq_distributor_and_worker()
+
+            worker_procs = util.start_threaded_workers(test_args["worker"], port_list)
+            proc_distributor = util.start_distributor([test_args["distributor"], "--ngram", str(n)] + options +
+                                                      [filename] + port_list)
+
+            util.join_workers(worker_procs)
+            distributor_output, distributor_err = proc_distributor.communicate()
+
+            if debug_tests:
+                util.create_test_debug_output("test_ngram_n=" + str(n) + "".join(options), num_workers,
+                                              correct_ngram_count, distributor_output)
+
+            assert distributor_output == correct_ngram_count, f"{num_workers} workers failed --ngram {n} {options} book 1 test."
+
+
+@pytest.mark.timeout(60)
+def test_heavy_hitters(program_args):
+    filename = test_args["filename_book_1"]
+    base_port = test_args["base_port"]
+    book_text = test_args["books"][0]
+    k = 20
+
+    file_out = open(filename, "wb")
+    file_out.write(book_text)
+    file_out.close()
+
+    book_text_str = book_text.decode("ascii", errors="ignore")
+    exact = Counter(re.findall("[a-z]+", book_text_str.lower()))
+    kth_count = sorted(exact.values(), reverse=True)[k - 1]
+
+    workers = np.arange(base_port, base_port + 4).tolist()
+    port_list = [str(x) for x in workers]
+
+    # kill any zmq procs currently running
+    util.kill_zmq_distributor_and_worker()
+
+    worker_procs = util.start_threaded_workers(test_args["worker"], port_list)
+    proc_distributor = util.start_distributor([test_args["distributor"], "--heavy", str(k), filename] + port_list)
+
+    util.join_workers(worker_procs)
+    distributor_output, distributor_err = proc_distributor.communicate()
+
+    lines = distributor_output.splitlines()
+    assert lines[0] == "word,frequency,error"
+    assert len(lines) == k + 1, f"Expected {k} heavy hitters, got {len(lines) - 1}."
+
+    for line in lines[1:]:
+        word, frequency, error = line.rsplit(",", 2)
+        frequency, error = int(frequency), int(error)
+        # reported count overestimates the exact one by at most the reported error
+        assert frequency - error <= exact[word] <= frequency, f"{word}: exact count {exact[word]} outside {frequency}-{error}."
+        # only words within the error of the true top-k may be reported
+        assert exact[word] + error >= kth_count, f"{word} ({exact[word]}) is not among the top {k} words."
+
+
+@pytest.mark.timeout(60)
+def test_distinct(program_args):
+    filename = test_args["filename_book_1"]
+    base_port = test_args["base_port"]
+    book_text = test_args["books"][0]
+
+    file_out = open(filename, "wb")
+    file_out.write(book_text)
+    file_out.close()
+
+    book_text_str = book_text.decode("ascii", errors="ignore")
+    vocabulary = len(set(re.findall("[a-z]+", book_text_str.lower())))
+
+    workers = np.arange(base_port, base_port + 4).tolist()
+    port_list = [str(x) for x in workers]
+
+    # kill any zmq procs currently running
+    util.kill_zmq_distributor_and_worker()
+
+    worker_procs = util.start_threaded_workers(test_args["worker"], port_list)
+    proc_distributor = util.start_distributor([test_args["distributor"], "--distinct", filename] + port_list)
+
+    util.join_workers(worker_procs)
+    distributor_output, distributor_err = proc_distributor.communicate()
+
+    lines = distributor_output.splitlines()
+    assert lines[0] == "distinct"
+    estimate = int(lines[1])
+    # standard error of the estimate is below 1%
+    assert abs(estimate - vocabulary) <= 0.03 * vocabulary, f"Estimated {estimate} distinct words, exact {vocabulary}."
+
+
+@pytest.mark.timeout(120)
+def test_utf8(program_args):
+    filename = test_args["filename_utf8"]
+    base_port = test_args["base_port"]
+    segment = 1 << 20
+    vocabulary = ["café", "über", "naïve", "señor", "garçon", "école", "Łódź", "smörgåsbord",
+                  "привіт", "жовтень", "їжак", "щастя", "ґанок", "єдність", "Київ"]
+    vocabulary += util.get_part_of_word_list(test_args["word_list"], 50)
+
+    def utf8_len(text):
+        return len(text.encode("utf-8"))
+
+    pieces = []
+    size = 0
+
+    def append(text):
+        nonlocal size
+        pieces.append(text)
+        size += utf8_len(text)
+
+    while size < 2 * segment + 4096:
+        word = random.choice(vocabulary)
+        word = random.choice([word, word.upper(), word.title()])
+        sep = random.choice([" ", ", ", ". ", "\n"])
+        first = next((k for k, b in enumerate(word.encode("utf-8")) if b >= 0x80), None)
+        if first is not None and random.random() < 0.5:
+            # the first multibyte character straddles a 16-byte block boundary
+            sep += " " * ((15 - size - len(sep) - first) % 16)
+        if size < segment <= size + len(sep) + utf8_len(word) + 64:
+            # the first segment cut falls inside a two-byte character, with word boundaries nearby
+            append(" " * (segment - 1 - size) + "ЖОВТЕНЬ ")
+        elif size < 2 * segment <= size + len(sep) + utf8_len(word) + 2048:
+            # the second one inside a word longer than a chunk: only the codepoint must stay whole
+            append(" " * (2 * segment - 1999 - size))
+            giant_at = len(pieces)
+            append("ж" * 2000 + " ")
+        else:
+            append(sep + word)
+    text = "".join(pieces)
+    data = text.encode("utf-8")
+    assert data[segment] & 0xC0 == 0x80 and data[2 * segment] & 0xC0 == 0x80
+
+    with open(filename, "wb") as file_out:
+        file_out.write(data)
+
+    # the pieces of the giant word are counted apart from the reference
+    pieces[giant_at] = " "
+    correct_word_count = util.count_words_utf8("".join(pieces))
+
+    for num_workers in [1, 4]:
+        workers = np.arange(base_port, base_port + num_workers).tolist()
+        port_list = [str(x) for x in workers]
+
+        # from the mapped file and from a pipe
+        for piped in [False, True]:
+            # kill any zmq procs currently running
+            util.kill_zmq_distributor_and_worker()
+
+            worker_procs = util.start_threaded_workers(test_args["worker"], port_list)
+            proc_distributor = util.start_distributor([test_args["distributor"], "--utf8",
+                                                       "--stdin" if piped else filename] + port_list,
+                                                      stdin=subprocess.PIPE if piped else None, encoding="utf-8")
+
+            distributor_output, distributor_err = proc_distributor.communicate(text if piped else None)
+            util.join_workers(worker_procs)
+
+            lines = distributor_output.splitlines(keepends=True)
+            giant = [line.rsplit(",", 1) for line in lines if set(line.rsplit(",", 1)[0]) == {"ж"}]
+            rest = "".join(line for line in lines if set(line.rsplit(",", 1)[0]) != {"ж"})
+
+            if debug_tests:
+                util.create_test_debug_output("test_utf8" + ("_stdin" if piped else ""), num_workers,
+                                              correct_word_count, rest)
+
+            assert rest == correct_word_count, f"{num_workers} workers failed the --utf8 test (piped: {piped})."
+            # words are clipped to 255 bytes, so only whole characters are checked here (decoding would fail otherwise)
+            assert len(giant) > 0 and all(len(w.encode("utf-8")) <= 255 for w, c in giant), \
+                "The word longer than a chunk was not cut into whole characters."
+
+
+@pytest.mark.timeout(180)
+def test_sorted_runs(program_args):
+    base_port = test_args["base_port"]
+    chunk_size = 1496
+    run_fanin = 64
+
+    # both books, and book 1 repeated until the runs need a second merge level
+    inputs = [(test_args["filename_book_1"], test_args["books"][0]),
+              (test_args["filename_book_2"], test_args["books"][1])]
+    repeat = run_fanin * run_fanin * chunk_size // len(test_args["books"][0]) + 1
+    inputs.append((test_args["filename_book_1"], test_args["books"][0] * repeat))
+
+    for filename, book_text in inputs:
+        # every chunk is one run: more than RUN_FANIN of them are merged in several levels
+        assert len(book_text) > run_fanin * chunk_size
+
+        file_out = open(filename, "wb")
+        file_out.write(book_text)
+        file_out.close()
+
+        for num_workers in [1, 4]:
+            workers = np.arange(base_port, base_port + num_workers).tolist()
+            port_list = [str(x) for x in workers]
+
+            outputs = []
+            for options in [[], ["--sorted-runs"]]:
+                # kill any zmq procs currently running
+                util.kill_zmq_distributor_and_worker()
+
+                worker_procs = util.start_threaded_workers(test_args["worker"], port_list)
+                proc_distributor = util.start_distributor([test_args["distributor"]] + options +
+                                                          [filename] + port_list)
+
+                distributor_output, distributor_err = proc_distributor.communicate()
+                util.join_workers(worker_procs)
+                outputs.append(distributor_output)
+
+            if debug_tests:
+                util.create_test_debug_output("test_sorted_runs", num_workers, outputs[0], outputs[1])
+
+            assert outputs[0] == util.count_words(book_text.decode("ascii", errors="ignore")), \
+                f"{num_workers} workers failed the default mode on {len(book_text)} bytes."
+            assert outputs[1] == outputs[0], \
+                f"{num_workers} workers: --sorted-runs differs from the default mode on {len(book_text)} bytes."
+
+
+@pytest.mark.timeout(120)
+def test_filters(program_args):
+    filename = test_args["filename_book_1"]
+    filename_stopwords = test_args["filename_stopwords"]
+    base_port = test_args["base_port"]
+    book_text = test_args["books"][0]
+
+    file_out = open(filename, "wb")
+    file_out.write(book_text)
+    file_out.close()
+
+    book_words = re.findall("[a-z]+", book_text.decode("ascii", errors="ignore").lower())
+
+    # frequent book words and words from the list, in mixed case: the spec no longer fits one frame
+    stopwords = [w for w, c in Counter(book_words).most_common(150)]
+    stopwords += [w.lower() for w in util.get_part_of_word_list(test_args["word_list"], 150)]
+    stop_text = "\n".join(random.choice([w, w.upper(), w.title()]) for w in stopwords) + "\n"
+    assert len(stop_text) > 1500
+
+    with open(filename_stopwords, "w") as f:
+        f.write(stop_text)
+
+    stop_set = set(w for w in re.findall("[a-z]+", stop_text.lower()))
+    prefixes = ["th", "s", "Wh"]
+
+    def reference(prefix, max_len):
+        words = [w for w in book_words if w not in stop_set and (max_len == 0 or len(w) <= max_len) and
+                 (not prefix or any(w.startswith(p.lower()) for p in prefixes))]
+        counts = sorted(Counter(words).items(), key=lambda a: (-a[1], a[0]))
+        return "word,frequency\n" + "".join(w + "," + str(c) + "\n" for w, c in counts)
+
+    for prefix, max_len in [(False, 0), (True, 0), (True, 6)]:
+        options = ["--stopwords", filename_stopwords]
+        if prefix:
+            options += ["--prefix", ",".join(prefixes)]
+        if max_len:
+            options += ["--max-len", str(max_len)]
+        correct_word_count = reference(prefix, max_len)
+
+        for num_workers in [1, 4]:
+            workers = np.arange(base_port, base_port + num_workers).tolist()
+            port_list = [str(x) for x in workers]
+
+            # kill any zmq procs currently running
+            util.kill_zmq_distributor_and_worker()
+
+            worker_procs = util.start_threaded_workers(test_args["worker"], port_list)
+            proc_distributor = util.start_distributor([test_args["distributor"]] + options + [filename] + port_list)
+
+            distributor_output, distributor_err = proc_distributor.communicate()
+            util.join_workers(worker_procs)
+
+            if debug_tests:
+                util.create_test_debug_output("test_filters" + "".join(options[2:]), num_workers,
+                                              correct_word_count, distributor_output)
+
+            assert distributor_output == correct_word_count, f"{num_workers} workers failed the filters {options}."
+
+
+@pytest.mark.timeout(120)
+def test_speculation(program_args):
+    filename = test_args["filename_book_1"]
+    base_port = test_args["base_port"]
+    book_text = test_args["books"][0]
+
+    file_out = open(filename, "wb")
+    file_out.write(book_text)
+    file_out.close()
+
+    correct_word_count = util.count_words(book_text.decode("ascii", errors="ignore"))
+
+    # the fake worker is the first one: reduce must not wait for it either
+    port_list = [str(x) for x in np.arange(base_port, base_port + 4).tolist()]
+
+    # kill any zmq procs currently running
+    util.kill_zmq_distributor_and_worker()
+
+    # python worker that accepts map requests and never answers them
+    context = zmq.Context.instance()
+    socket = context.socket(zmq.REP)
+    socket.setsockopt(zmq.LINGER, 0)
+    socket.bind("tcp://*:" + port_list[0])
+
+    worker_procs = util.start_threaded_workers(test_args["worker"], port_list[1:])
+    proc_distributor = util.start_distributor([test_args["distributor"], "--deadline", "200", filename] + port_list,
+                                              stderr=subprocess.PIPE)
+    distributor_output, distributor_err = proc_distributor.communicate()
+    util.join_workers(worker_procs)
+    socket.close()
+
+    if debug_tests:
+        util.create_test_debug_output("test_speculation_stall", 4, correct_word_count, distributor_output)
+
+    assert distributor_output == correct_word_count, "Distributor failed book 1 with a worker that never answers."
+    assert "Re-dispatched" in distributor_err, "Distributor did not re-dispatch the chunks of the stalled worker."
+
+    # python worker that answers one chunk of a batch and closes: the rest is requeued
+    util.kill_zmq_distributor_and_worker()
+
+    manager = multiprocessing.Manager()
+    return_dict = manager.dict()
+    fake = multiprocessing.Process(target=util.run_worker_close_mid_batch, args=(port_list[0], return_dict))
+    fake.start()
+
+    worker_procs = util.start_threaded_workers(test_args["worker"], port_list[1:])
+    proc_distributor = util.start_distributor([test_args["distributor"], "--deadline", "200", "--batch", "8",
+                                               filename] + port_list, stderr=subprocess.PIPE)
+    distributor_output, distributor_err = proc_distributor.communicate()
+    util.join_workers(worker_procs)
+    fake.join()
+
+    if debug_tests:
+        util.create_test_debug_output("test_speculation_close", 4, correct_word_count, distributor_output)
+
+    assert return_dict[port_list[0]] > 0, "The fake worker got no map request."
+    assert distributor_output == correct_word_count, "Distributor failed book 1 with a worker closed mid-batch."
+    assert re.search("map reply has 1 of [2-8] frames", distributor_err), \
+        "Distributor did not notice the missing frames of the batch."
+    assert "Re-dispatched" in distributor_err, "Distributor did not re-dispatch the chunks of the closed worker."
+
+
+@pytest.mark.timeout(60)
+def test_local(program_args):
+    # no workers: the distributor counts in its own threads
+    util.kill_zmq_distributor_and_worker()
+
+    for filename, book_text in [(test_args["filename_book_1"], test_args["books"][0]),
+                                (test_args["filename_book_2"], test_args["books"][1])]:
+        file_out = open(filename, "wb")
+        file_out.write(book_text)
+        file_out.close()
+
+        correct_word_count = util.count_words(book_text.decode("ascii", errors="ignore"))
+
+        for num_threads in [1, 4]:
+            proc_distributor = util.start_distributor([test_args["distributor"], "--local", str(num_threads),
+                                                       filename])
+            distributor_output, distributor_err = proc_distributor.communicate()
+
+            if debug_tests:
+                util.create_test_debug_output("test_local_" + filename, num_threads, correct_word_count,
+                                              distributor_output)
+
+            assert proc_distributor.returncode == 0, f"--local {num_threads} failed on {filename}."
+            assert distributor_output == correct_word_count, f"--local {num_threads} miscounted {filename}."
+
+
+# variants that must print exactly what the default mode prints:
+# distributor options, worker endpoint and distributor endpoint of a port
+# (a plain port is tried over the local ipc socket of the worker first, then over TCP)
+same_as_default_variants = {
+    "batch": (["--batch", "8"], str, str),
+    "host_port": ([], lambda p: "127.0.0.1:" + str(p), lambda p: "127.0.0.1:" + str(p)),
+    "ipc": ([], lambda p: "ipc://@rn-praxis3-test-" + str(p), lambda p: "ipc://@rn-praxis3-test-" + str(p)),
+    "tcp_fallback": ([], lambda p: "tcp://*:" + str(p), str),
+    "normalize": (["--normalize"], str, str),
+}
+
+
+@pytest.mark.timeout(60)
+@pytest.mark.parametrize("variant", list(same_as_default_variants))
+def test_same_as_default(program_args, variant):
+    filename = test_args["filename_book_1"]
+    base_port = test_args["base_port"]
+    book_text = test_args["books"][0]
+
+    file_out = open(filename, "wb")
+    file_out.write(book_text)
+    file_out.close()
+
+    ports = np.arange(base_port, base_port + 4).tolist()
+
+    outputs = []
+    for options, worker_endpoint, distributor_endpoint in [([], str, str), same_as_default_variants[variant]]:
+        # kill any zmq procs currently running
+        util.kill_zmq_distributor_and_worker()
+
+        worker_procs = util.start_threaded_workers(test_args["worker"], [worker_endpoint(p) for p in ports])
+        proc_distributor = util.start_distributor([test_args["distributor"]] + options + [filename] +
+                                                  [distributor_endpoint(p) for p in ports])
+
+        distributor_output, distributor_err = proc_distributor.communicate()
+        util.join_workers(worker_procs)
+        outputs.append(distributor_output)
+
+    correct_word_count = util.count_words(book_text.decode("ascii", errors="ignore"))
+
+    if debug_tests:
+        util.create_test_debug_output("test_same_as_default_" + variant, 4, outputs[0], outputs[1])
+
+    assert outputs[0] == correct_word_count, "Distributor failed book 1 in the default mode."
+    assert outputs[1] == outputs[0], f"The {variant} variant differs from the default mode."
+
+
 @pytest.mark.timeout(30)
 def test_interoperability(program_args):
     base_port = test_args["base_port"]
@@ -11,6 +11,7 @@ import time
 import xml.etree.ElementTree as ET
 
 from collections import Counter
+from itertools import groupby
 from typing import List, Union
 
 import numpy as np
@@ -91,6 +92,14 @@ def init_tests(args):
 
     filename_valgrind = "valgrind_test.txt"
 
+    filename_checkpoint = "checkpoint_test.wccp"
+
+    filename_cache = "cache_test.wcrc"
+
+    filename_utf8 = "utf8_test.txt"
+
+    filename_stopwords = "stopwords_test.txt"
+
 
     test_args = {"is_ubuntu20_eecs_system": is_ubuntu20_eecs(),
                  "distributor": distributor_exec,
@@ -108,6 +117,10 @@ def init_tests(args):
                  "filename_book_2": filename_book_2,
                  "filename_interop": filename_interop,
                  "filename_valgrind": filename_valgrind,
+                 "filename_checkpoint": filename_checkpoint,
+                 "filename_cache": filename_cache,
+                 "filename_utf8": filename_utf8,
+                 "filename_stopwords": filename_stopwords,
                  }
 
     generate_test_files(test_args)
@@ -316,6 +329,33 @@ def count_words(input_string):
     return output_string
 
 
+# reference for --utf8: words are runs of str.isalpha() characters, folded with str.casefold()
+def count_words_utf8(input_string):
+    words = Counter("".join(g).casefold() for alpha, g in groupby(input_string, str.isalpha) if alpha)
+    words = sorted(words.items(), key=lambda a: (-a[1], a[0]))
+
+    output_string = "word,frequency\n"
+
+    for w in words:
+        output_string += w[0] + "," + str(w[1]) + "\n"
+
+    return output_string
+
+
+def count_ngrams(input_string, n):
+    words = re.findall("[a-z]+", input_string.lower())
+
+    ngrams = Counter(" ".join(words[i:i + n]) for i in range(len(words) - n + 1))
+    ngrams = sorted(ngrams.items(), key=lambda a: (-a[1], a[0]))
+
+    output_string = "word,frequency\n"
+
+    for g in ngrams:
+        output_string += g[0] + "," + str(g[1]) + "\n"
+
+    return output_string
+
+
 def create_test_debug_output(test_name, num_w, expected_output, dist_output):
     debug_base_path = "debug/"
     if not os.path.isdir(debug_base_path):
@@ -373,8 +413,14 @@ def start_threaded_workers(worker_exec : Union[str, List[List[str]]], port_list
         return [proc_workers]
 
 
-def start_distributor(dist_args : List[str]):
-    return subprocess.Popen(dist_args, stdout=subprocess.PIPE, encoding="ascii")
+def start_distributor(dist_args : List[str], stdin=None, stderr=None, encoding="ascii"):
+    return subprocess.Popen(dist_args, stdin=stdin, stdout=subprocess.PIPE, stderr=stderr, encoding=encoding)
+
+
+# map reply of the reference word count: words in first-seen order, one "1" per occurrence
+def map_reply(text):
+    words = Counter(re.findall("[a-z]+", text.lower()))
+    return "".join(w + "1" * c for w, c in words.items()) + "\0"
 
 
 def run_worker_load_distribution(port, return_dict):
@@ -405,6 +451,33 @@ def run_worker_load_distribution(port, return_dict):
     return_dict[port] = received_requests
 
 
+# python worker that counts like the real one until it receives a batch of several chunks,
+# answers only the first chunk of that batch and closes its socket
+def run_worker_close_mid_batch(port, return_dict):
+    context = zmq.Context.instance()
+    socket = context.socket(zmq.REP)
+    socket.setsockopt(zmq.LINGER, 0)
+    socket.bind("tcp://*:" + str(port))
+
+    received_requests = 0
+
+    while True:
+        frames = socket.recv_multipart()
+        if frames[0][:3] == b"rip":
+            socket.send(b"rip\0")
+            break
+        received_requests += 1
+        chunks = [frames[0][3:]] if len(frames) == 1 else frames[1:]
+        replies = [map_reply(c.rstrip(b"\0").decode("ascii")).encode("ascii") for c in chunks]
+        if len(chunks) > 1:
+            socket.send(replies[0])
+            break
+        socket.send_multipart(replies)
+    socket.close()
+
+    return_dict[port] = received_requests
+
+
 def check_valgrind_output_no_errors(filename):
     if not os.path.isfile(filename):
         return True
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""Generates common_words.h: a perfect hash of the most frequent words.
+
+Words are counted in the given texts exactly as the ASCII tokenizer in
+wordcount.c sees them (runs of ASCII letters, lowercased), and the most
+frequent ones get ids 0, 1, ... by decreasing frequency (ties by word).
+The table is built with CHD (hash-and-displace): the FNV-1a hash of a
+word picks a bucket (low bits) and a start and step for its slot (high
+bits); each bucket gets the smallest displacement d that places all its
+words into free slots. The lookup in wordcount.c (wc_common_word) must
+compute the hash the same way.
+
+Usage: python3 tools/gen_common_words.py [-n N] test_files/*.txt > common_words.h
+"""
+import argparse
+import collections
+import os
+import re
+
+FNV_OFFSET = 0xCBF29CE484222325
+FNV_PRIME = 0x100000001B3
+MASK64 = (1 << 64) - 1
+MASK32 = (1 << 32) - 1
+
+
+def fnv1a(word):
+    h = FNV_OFFSET
+    for b in word:
+        h = ((h ^ b) * FNV_PRIME) & MASK64
+    return h
+
+
+def slot_of(h, d, n_slots):
+    f1 = h >> 32
+    f2 = ((h >> 16) & MASK32) | 1
+    return ((f1 + d * f2) & MASK32) & (n_slots - 1)
+
+
+def top_words(paths, n):
+    counts = collections.Counter()
+    for path in paths:
+        with open(path, "rb") as f:
+            counts.update(w.lower() for w in re.findall(rb"[A-Za-z]+", f.read()))
+    ranked = sorted(counts.items(), key=lambda kv: (-kv[1], kv[0]))
+    return [w for w, _ in ranked[:n]]
+
+
+def build(words, n_buckets, n_slots):
+    buckets = [[] for _ in range(n_buckets)]
+    for i, w in enumerate(words):
+        h = fnv1a(w)
+        buckets[h & (n_buckets - 1)].append((i, h))
+    disp = [0] * n_buckets
+    slots = [-1] * n_slots
+    for b in sorted(range(n_buckets), key=lambda b: -len(buckets[b])):
+        if not buckets[b]:
+            continue
+        for d in range(1 << 16):
+            taken = [slot_of(h, d, n_slots) for _, h in buckets[b]]
+            if len(set(taken)) == len(taken) and all(slots[s] < 0 for s in taken):
+                break
+        else:
+            raise SystemExit("no displacement for bucket %d" % b)
+        disp[b] = d
+        for (i, _), s in zip(buckets[b], taken):
+            slots[s] = i
+    return disp, slots
+
+
+def c_rows(values, per_row):
+    rows = []
+    for i in range(0, len(values), per_row):
+        rows.append("    " + ", ".join(str(v) for v in values[i:i + per_row]) + ",")
+    return "\n".join(rows)
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("-n", type=int, default=1024, help="number of words")
+    ap.add_argument("texts", nargs="+")
+    args = ap.parse_args()
+
+    words = top_words(args.texts, args.n)
+    n_slots = 1
+    while n_slots < 2 * len(words):
+        n_slots *= 2
+    n_buckets = max(1, n_slots // 8)
+    disp, slots = build(words, n_buckets, n_slots)
+
+    sources = " ".join(os.path.basename(p) for p in args.texts)
+    print("/* Згенеровано tools/gen_common_words.py (%s), не редагувати. */" % sources)
+    print("#ifndef COMMON_WORDS_H")
+    print("#define COMMON_WORDS_H")
+    print()
+    print("#include <stdint.h>")
+    print()
+    print("#define COMMON_WORDS_COUNT %d" % len(words))
+    print("#define COMMON_BUCKETS %d      // Степінь двійки" % n_buckets)
+    print("#define COMMON_SLOTS %d       // Степінь двійки" % n_slots)
+    print("#define COMMON_MAX_LEN %d" % max(len(w) for w in words))
+    print()
+    print("// Зміщення d для кожного кошика (молодші біти хешу)")
+    print("static const uint16_t common_disp[COMMON_BUCKETS] = {")
+    print(c_rows(disp, 16))
+    print("};")
+    print()
+    print("// Номер слова в комірці або -1")
+    print("static const int16_t common_slot[COMMON_SLOTS] = {")
+    print(c_rows(slots, 16))
+    print("};")
+    print()
+    print("// Слова за спаданням частоти")
+    print("static const char common_words[COMMON_WORDS_COUNT][COMMON_MAX_LEN + 1] = {")
+    line = "   "
+    for w in words:
+        piece = ' "%s",' % w.decode("ascii")
+        if len(line) + len(piece) > 76:
+            print(line)
+            line = "   "
+        line += piece
+    print(line)
+    print("};")
+    print()
+    print("static const uint8_t common_len[COMMON_WORDS_COUNT] = {")
+    print(c_rows([len(w) for w in words], 16))
+    print("};")
+    print()
+    print("#endif /* COMMON_WORDS_H */")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,77 @@
+#!/usr/bin/env python3
+"""Generates unicode_tables.h for the UTF-8 tokenizer in wordcount.c.
+
+Word characters are Unicode letters (L*) and combining marks (Mn, Mc)
+above U+007F; ASCII is classified directly in wordcount.c. Case folding
+is the simple (one code point to one code point) folding, taken from
+str.casefold() with str.lower() as a fallback.
+
+Usage: python3 tools/gen_unicode_tables.py > unicode_tables.h
+"""
+import sys
+import unicodedata
+
+WORD_CATEGORIES = {"Lu", "Ll", "Lt", "Lm", "Lo", "Mn", "Mc"}
+
+
+def word_ranges():
+    ranges = []
+    for cp in range(0x80, sys.maxunicode + 1):
+        if unicodedata.category(chr(cp)) not in WORD_CATEGORIES:
+            continue
+        if ranges and ranges[-1][1] == cp - 1:
+            ranges[-1][1] = cp
+        else:
+            ranges.append([cp, cp])
+    return ranges
+
+
+def simple_fold(cp):
+    for folded in (chr(cp).casefold(), chr(cp).lower()):
+        if len(folded) == 1 and ord(folded) != cp:
+            return ord(folded)
+    return None
+
+
+def fold_runs():
+    runs = []  # [lo, hi, delta, stride]
+    for cp in range(0x80, sys.maxunicode + 1):
+        f = simple_fold(cp)
+        if f is None:
+            continue
+        delta = f - cp
+        if runs:
+            lo, hi, d, stride = runs[-1]
+            if d == delta and (cp - hi == stride or (lo == hi and cp - hi in (1, 2))):
+                runs[-1][1] = cp
+                runs[-1][3] = cp - hi if lo == hi else stride
+                continue
+        runs.append([cp, cp, delta, 1])
+    return runs
+
+
+def main():
+    out = sys.stdout
+    out.write("/* Згенеровано tools/gen_unicode_tables.py (Unicode %s), не редагувати. */\n"
+              % unicodedata.unidata_version)
+    out.write("#ifndef UNICODE_TABLES_H\n#define UNICODE_TABLES_H\n\n#include <stdint.h>\n\n")
+
+    ranges = word_ranges()
+    out.write("// Діапазони літер і знаків (>= U+0080), за зростанням\n")
+    out.write("static const uint32_t uc_word_ranges[][2] = {\n")
+    for lo, hi in ranges:
+        out.write("    {0x%05X, 0x%05X},\n" % (lo, hi))
+    out.write("};\n\n")
+
+    runs = fold_runs()
+    out.write("// Проста згортка регістру: cp у [lo, hi] з кроком stride -> cp + delta\n")
+    out.write("typedef struct UcFoldRun {\n    uint32_t lo, hi;\n    int32_t delta;\n"
+              "    uint32_t stride;\n} UcFoldRun;\n\n")
+    out.write("static const UcFoldRun uc_fold_runs[] = {\n")
+    for lo, hi, delta, stride in runs:
+        out.write("    {0x%05X, 0x%05X, %d, %d},\n" % (lo, hi, delta, stride))
+    out.write("};\n\n#endif /* UNICODE_TABLES_H */\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,2013 @@
+/*************************************************************
+ *  wordcount.c - реалізація libwordcount (див. wordcount.h)
+ *
+ *  Код перенесено з zmq_worker.c (Ordered HashMap, map_function,
+ *  reduce_function) без зміни формату відповідей, але без
+ *  статичних буферів і strtok, тож він повторно вхідний.
+ *  Таблиці Unicode (unicode_tables.h) генерує
+ *  tools/gen_unicode_tables.py, досконалий хеш частих слів
+ *  (common_words.h) - tools/gen_common_words.py.
+ *************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "wordcount.h"
+#include "unicode_tables.h"
+#include "common_words.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*************************************************************
+ *   ХЕШ
+ *
+ *  Обробляє по 16 байт за крок (множення 64x64->128 і
+ *  згортання, як у wyhash). Зерно словника випадкове, тож
+ *  підібрати вхід із колізіями наперед не можна.
+ *************************************************************/
+__extension__ typedef unsigned __int128 wc_u128;
+
+static uint64_t hash_mix(uint64_t a, uint64_t b) {
+    wc_u128 r = (wc_u128)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+static uint64_t hash_read64(const unsigned char *p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static uint64_t hash_read32(const unsigned char *p) {
+    uint32_t v;
+    memcpy(&v, p, 4);
+    return v;
+}
+
+uint64_t wc_hash64(const void *data, size_t len, uint64_t seed) {
+    const uint64_t p0 = 0xa0761d6478bd642fULL, p1 = 0xe7037ed1a0b428dbULL;
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t a, b;
+    seed ^= p0;
+    if (len <= 16) {
+        if (len >= 8) {
+            a = hash_read64(p);
+            b = hash_read64(p + len - 8);
+        } else if (len >= 4) {
+            a = hash_read32(p);
+            b = hash_read32(p + len - 4);
+        } else if (len > 0) {
+            a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t rest = len;
+        while (rest > 16) {
+            seed = hash_mix(hash_read64(p) ^ p1, hash_read64(p + 8) ^ seed);
+            p += 16;
+            rest -= 16;
+        }
+        a = hash_read64(p + rest - 16);
+        b = hash_read64(p + rest - 8);
+    }
+    uint64_t h = hash_mix(p1 ^ len, hash_mix(a ^ p1, b ^ seed));
+    return h ? h : 1;
+}
+
+/*
+ * Зерно нового словника: час і адреса (ASLR) перемішуються, тож
+ * зерна різні в різних процесах і словниках без спільного стану.
+ */
+static uint64_t map_seed(const void *map) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t t = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    return hash_mix(t ^ 0x9E3779B97F4A7C15ULL, (uint64_t)(uintptr_t)map | 1);
+}
+
+/*************************************************************
+ *   ЧАСТІ СЛОВА
+ *
+ *  Досконалий хеш CHD, побудований наперед (common_words.h):
+ *  хеш FNV-1a слова дає кошик (молодші біти), а зміщення
+ *  кошика - єдину можливу комірку. Без проб і ланцюжків; одне
+ *  memcmp відсіює слова, яких у таблиці немає.
+ *************************************************************/
+_Static_assert(COMMON_WORDS_COUNT == WC_COMMON_WORDS,
+               "common_words.h не відповідає WC_COMMON_WORDS");
+
+int wc_common_word(const char *word, size_t len) {
+    if (len == 0 || len > COMMON_MAX_LEN)
+        return -1;
+    // FNV-1a, як у tools/gen_common_words.py
+    uint64_t h = 0xCBF29CE484222325ULL;
+    for (size_t i = 0; i < len; i++)
+        h = (h ^ (unsigned char)word[i]) * 0x100000001B3ULL;
+    uint32_t d = common_disp[h & (COMMON_BUCKETS - 1)];
+    uint32_t slot = ((uint32_t)(h >> 32) + d * ((uint32_t)(h >> 16) | 1u)) & (COMMON_SLOTS - 1);
+    int id = common_slot[slot];
+    if (id < 0 || common_len[id] != len ||
+        memcmp(common_words[id], word, len) != 0)
+        return -1;
+    return id;
+}
+
+const char *wc_common_word_text(int id) {
+    return common_words[id];
+}
+
+/*************************************************************
+ *   ВПОРЯДКОВАНИЙ ХЕШ-СЛОВНИК
+ *************************************************************/
+
+WCMap *wc_map_create_seeded(uint64_t seed) {
+    WCMap *map = malloc(sizeof(WCMap));
+    if (!map) return NULL;
+    map->buckets = calloc(WC_HASH_SIZE, sizeof(WCNode *));
+    if (!map->buckets) {
+        free(map);
+        return NULL;
+    }
+    map->n_buckets = WC_HASH_SIZE;
+    map->order_head = NULL;
+    map->order_tail = NULL;
+    map->size = 0;
+    map->seed = seed;
+    return map;
+}
+
+WCMap *wc_map_create(void) {
+    WCMap *map = wc_map_create_seeded(0);
+    if (map)
+        map->seed = map_seed(map);
+    return map;
+}
+
+// Подвоює кількість бакетів (ланцюжок порядку вставки не змінюється)
+static void wc_map_grow(WCMap *map) {
+    size_t n = map->n_buckets * 2;
+    WCNode **buckets = calloc(n, sizeof(WCNode *));
+    if (!buckets) return; // Лишаємось із довшими ланцюжками
+    for (WCNode *node = map->order_head; node; node = node->order_next) {
+        size_t index = (size_t)node->hash & (n - 1);
+        node->next = buckets[index];
+        buckets[index] = node;
+    }
+    free(map->buckets);
+    map->buckets = buckets;
+    map->n_buckets = n;
+}
+
+WCNode *wc_map_find(const WCMap *map, const char *word) {
+    size_t len = strlen(word);
+    uint64_t hash = wc_hash64(word, len, map->seed);
+    WCNode *node = map->buckets[hash & (map->n_buckets - 1)];
+    while (node) {
+        if (node->hash == hash && node->len == len && memcmp(node->word, word, len) == 0)
+            return node;
+        node = node->next;
+    }
+    return NULL;
+}
+
+/*
+ * wc_map_add_hashed: якщо слово вже є, збільшує його лічильник,
+ * інакше створює вузол на початку бакета й у кінці ланцюжка
+ * вставки. Слова порівнюються лише за збігу збережених хешів і
+ * довжин (як у WCIntern), тож memcmp не читає за кінцем слова.
+ * Повертає 0 або -1, якщо не вистачило памʼяті.
+ */
+int wc_map_add_hashed(WCMap *map, const char *word, size_t len, uint64_t hash, int count) {
+    size_t index = (size_t)hash & (map->n_buckets - 1);
+    for (WCNode *node = map->buckets[index]; node; node = node->next) {
+        if (node->hash == hash && node->len == len && memcmp(node->word, word, len) == 0) {
+            node->count += count;
+            return 0;
+        }
+    }
+    WCNode *new_node = malloc(sizeof(WCNode));
+    if (!new_node) return -1;
+    new_node->word = malloc(len + 1);
+    if (!new_node->word) {
+        free(new_node);
+        return -1;
+    }
+    memcpy(new_node->word, word, len);
+    new_node->word[len] = '\0';
+    new_node->len = len;
+    new_node->hash = hash;
+    new_node->count = count;
+    new_node->next = map->buckets[index];
+    map->buckets[index] = new_node;
+    new_node->order_next = NULL;
+    if (map->order_tail)
+        map->order_tail->order_next = new_node;
+    else
+        map->order_head = new_node;
+    map->order_tail = new_node;
+    map->size++;
+    if (map->size > 2 * map->n_buckets)
+        wc_map_grow(map);
+    return 0;
+}
+
+int wc_map_add(WCMap *map, const char *word, int count) {
+    size_t len = strlen(word);
+    return wc_map_add_hashed(map, word, len, wc_hash64(word, len, map->seed), count);
+}
+
+static int cmp_node_word(const void *a, const void *b) {
+    return strcmp((*(WCNode *const *)a)->word, (*(WCNode *const *)b)->word);
+}
+
+WCNode **wc_map_sorted(const WCMap *map) {
+    WCNode **nodes = malloc((map->size ? map->size : 1) * sizeof(WCNode *));
+    if (!nodes) return NULL;
+    size_t n = 0;
+    for (WCNode *node = map->order_head; node; node = node->order_next)
+        nodes[n++] = node;
+    qsort(nodes, n, sizeof(WCNode *), cmp_node_word);
+    return nodes;
+}
+
+void wc_map_free(WCMap *map) {
+    if (!map) return;
+    WCNode *node = map->order_head;
+    while (node) {
+        WCNode *tmp = node;
+        node = node->order_next;
+        free(tmp->word);
+        free(tmp);
+    }
+    free(map->buckets);
+    free(map);
+}
+
+/*************************************************************
+ *   НАЛАШТУВАННЯ
+ *************************************************************/
+
+/*
+ * Фільтр стоп-слів і префіксів. Стоп-слово перевіряється у два
+ * кроки: фільтр Блума (BLOOM_BITS_PER_KEY біт на слово,
+ * BLOOM_HASHES хешів) відсіює більшість звичайних слів без
+ * жодного порівняння рядків, а для решти точну відповідь дає
+ * досконалий хеш CHD (hash-and-displace): кожне стоп-слово має
+ * власну комірку таблиці, тож перевірка - одне порівняння.
+ */
+#define BLOOM_BITS_PER_KEY 10
+#define BLOOM_HASHES 4
+#define CHD_BUCKET_KEYS 4       // Середня к-сть слів у кошику CHD
+#define CHD_MAX_SEEDS 16        // Спроб побудови з різним зерном
+
+struct WCFilter {
+    char **stop;                // Стоп-слова (власні копії, відсортовані)
+    size_t n_stop, cap_stop;
+    char **prefix;              // Слово має починатися з одного з префіксів
+    size_t n_prefix, cap_prefix;
+    // Будує filter_build
+    uint64_t seed;
+    uint64_t *bloom;
+    uint64_t bloom_mask;        // К-сть бітів - 1 (степінь двійки)
+    uint32_t *disp;             // Зсув для кожного кошика CHD
+    size_t n_buckets;
+    int32_t *slots;             // Індекс стоп-слова в комірці або -1
+    size_t n_slots;
+};
+
+static uint64_t filter_hash(const char *s, size_t len, uint64_t seed) {
+    return wc_hash64(s, len, seed);
+}
+
+static size_t chd_bucket(const WCFilter *f, uint64_t h) {
+    return (size_t)((h >> 40) % f->n_buckets);
+}
+
+static size_t chd_slot(const WCFilter *f, uint64_t h, uint32_t d) {
+    uint64_t f1 = h % f->n_slots;
+    uint64_t f2 = (h >> 20) % f->n_slots;
+    uint64_t d0 = d / f->n_slots;
+    uint64_t d1 = d % f->n_slots;
+    return (size_t)((f1 + d0 * f2 + d1) % f->n_slots);
+}
+
+static void filter_free(WCFilter *f) {
+    if (!f) return;
+    for (size_t i = 0; i < f->n_stop; i++)
+        free(f->stop[i]);
+    for (size_t i = 0; i < f->n_prefix; i++)
+        free(f->prefix[i]);
+    free(f->stop);
+    free(f->prefix);
+    free(f->bloom);
+    free(f->disp);
+    free(f->slots);
+    free(f);
+}
+
+static int list_add(char ***items, size_t *n, size_t *cap, const char *s, size_t len) {
+    if (*n == *cap) {
+        size_t new_cap = *cap ? *cap * 2 : 16;
+        char **tmp = realloc(*items, new_cap * sizeof(char *));
+        if (!tmp) return -1;
+        *items = tmp;
+        *cap = new_cap;
+    }
+    char *copy = malloc(len + 1);
+    if (!copy) return -1;
+    memcpy(copy, s, len);
+    copy[len] = '\0';
+    (*items)[(*n)++] = copy;
+    return 0;
+}
+
+static int cmp_str(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/*
+ * chd_try: розміщує всі стоп-слова з зерном seed. Кошики
+ * обробляються від найбільшого; для кошика перебираються зсуви
+ * d, доки всі його слова не потраплять у вільні різні комірки.
+ */
+static int chd_try(WCFilter *f, uint64_t seed) {
+    size_t n = f->n_stop;
+    uint64_t *h = malloc(n * sizeof(uint64_t));
+    size_t *start = calloc(f->n_buckets + 1, sizeof(size_t));
+    size_t *members = malloc(n * sizeof(size_t));
+    size_t *fill = calloc(f->n_buckets, sizeof(size_t));
+    int rc = -1;
+    if (!h || !start || !members || !fill) goto out;
+
+    // Кошики як відрізки members (сортування підрахунком)
+    for (size_t i = 0; i < n; i++) {
+        h[i] = filter_hash(f->stop[i], strlen(f->stop[i]), seed);
+        start[chd_bucket(f, h[i]) + 1]++;
+    }
+    size_t max_size = 0;
+    for (size_t b = 0; b < f->n_buckets; b++) {
+        if (start[b + 1] > max_size) max_size = start[b + 1];
+        start[b + 1] += start[b];
+    }
+    for (size_t i = 0; i < n; i++) {
+        size_t b = chd_bucket(f, h[i]);
+        members[start[b] + fill[b]++] = i;
+    }
+
+    for (size_t s = 0; s < f->n_slots; s++)
+        f->slots[s] = -1;
+    memset(f->disp, 0, f->n_buckets * sizeof(uint32_t));
+    uint64_t max_d = (uint64_t)f->n_slots * f->n_slots;
+    if (max_d > UINT32_MAX) max_d = UINT32_MAX;
+
+    for (size_t size = max_size; size > 0; size--) {
+        for (size_t b = 0; b < f->n_buckets; b++) {
+            size_t k = start[b + 1] - start[b];
+            if (k != size) continue;
+            const size_t *m = members + start[b];
+            uint32_t d;
+            for (d = 0; d < max_d; d++) {
+                size_t j;
+                for (j = 0; j < k; j++) {
+                    size_t pos = chd_slot(f, h[m[j]], d);
+                    if (f->slots[pos] >= 0) break;
+                    size_t q;
+                    for (q = 0; q < j; q++) {
+                        if (chd_slot(f, h[m[q]], d) == pos) break;
+                    }
+                    if (q < j) break;
+                }
+                if (j == k) break;
+            }
+            if (d == max_d) goto out;
+            f->disp[b] = d;
+            for (size_t j = 0; j < k; j++)
+                f->slots[chd_slot(f, h[m[j]], d)] = (int32_t)m[j];
+        }
+    }
+    rc = 0;
+
+out:
+    free(h);
+    free(start);
+    free(members);
+    free(fill);
+    return rc;
+}
+
+// Прибирає повтори стоп-слів і будує фільтр Блума та CHD
+static int filter_build(WCFilter *f) {
+    if (f->n_stop == 0) return 0;
+    qsort(f->stop, f->n_stop, sizeof(char *), cmp_str);
+    size_t n = 0;
+    for (size_t i = 0; i < f->n_stop; i++) {
+        if (n > 0 && strcmp(f->stop[n - 1], f->stop[i]) == 0)
+            free(f->stop[i]);
+        else
+            f->stop[n++] = f->stop[i];
+    }
+    f->n_stop = n;
+
+    f->n_buckets = (n + CHD_BUCKET_KEYS - 1) / CHD_BUCKET_KEYS;
+    f->n_slots = n + n / 4 + 1;
+    f->disp = malloc(f->n_buckets * sizeof(uint32_t));
+    f->slots = malloc(f->n_slots * sizeof(int32_t));
+    if (!f->disp || !f->slots) return -1;
+    int seed_ok = 0;
+    for (uint64_t seed = 1; seed <= CHD_MAX_SEEDS && !seed_ok; seed++) {
+        if (chd_try(f, seed) == 0) {
+            f->seed = seed;
+            seed_ok = 1;
+        }
+    }
+    if (!seed_ok) return -1;
+
+    uint64_t bits = 64;
+    while (bits < (uint64_t)n * BLOOM_BITS_PER_KEY) bits *= 2;
+    f->bloom = calloc(bits / 64, sizeof(uint64_t));
+    if (!f->bloom) return -1;
+    f->bloom_mask = bits - 1;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t h = filter_hash(f->stop[i], strlen(f->stop[i]), f->seed);
+        uint32_t h1 = (uint32_t)h, h2 = (uint32_t)(h >> 32) | 1;
+        for (uint32_t k = 0; k < BLOOM_HASHES; k++) {
+            uint64_t bit = (h1 + k * h2) & f->bloom_mask;
+            f->bloom[bit / 64] |= 1ULL << (bit % 64);
+        }
+    }
+    return 0;
+}
+
+static int filter_is_stopword(const WCFilter *f, const char *word, size_t len) {
+    if (f->n_stop == 0) return 0;
+    uint64_t h = filter_hash(word, len, f->seed);
+    uint32_t h1 = (uint32_t)h, h2 = (uint32_t)(h >> 32) | 1;
+    for (uint32_t k = 0; k < BLOOM_HASHES; k++) {
+        uint64_t bit = (h1 + k * h2) & f->bloom_mask;
+        if (!(f->bloom[bit / 64] & (1ULL << (bit % 64))))
+            return 0;
+    }
+    int32_t idx = f->slots[chd_slot(f, h, f->disp[chd_bucket(f, h)])];
+    return idx >= 0 && strncmp(f->stop[idx], word, len) == 0 && f->stop[idx][len] == '\0';
+}
+
+int wc_word_accepted(const WCConfig *cfg, const char *word, size_t len) {
+    if (!cfg) return 1;
+    if (cfg->min_len > 0 || cfg->max_len > 0) {
+        // Довжина в символах: байти продовження UTF-8 не рахуються
+        size_t chars = 0;
+        for (size_t i = 0; i < len; i++)
+            chars += ((unsigned char)word[i] & 0xC0) != 0x80;
+        if (cfg->min_len > 0 && chars < (size_t)cfg->min_len) return 0;
+        if (cfg->max_len > 0 && chars > (size_t)cfg->max_len) return 0;
+    }
+    const WCFilter *f = cfg->filter;
+    if (!f) return 1;
+    if (f->n_prefix > 0) {
+        size_t i;
+        for (i = 0; i < f->n_prefix; i++) {
+            size_t plen = strlen(f->prefix[i]);
+            if (plen <= len && memcmp(f->prefix[i], word, plen) == 0) break;
+        }
+        if (i == f->n_prefix) return 0;
+    }
+    return !filter_is_stopword(f, word, len);
+}
+
+// Розбирає невідʼємне число len байтів; -1, якщо це не число
+static int parse_count(const char *p, size_t len) {
+    if (len == 0 || len > 9) return -1;
+    int v = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (!isdigit((unsigned char)p[i])) return -1;
+        v = v * 10 + (p[i] - '0');
+    }
+    return v;
+}
+
+int wc_config_parse(WCConfig *cfg, const char *spec) {
+    WCConfig tmp = WC_CONFIG_DEFAULT;
+    WCFilter *f = calloc(1, sizeof(WCFilter));
+    if (!f) return -1;
+    const char *p = spec;
+    while (*p) {
+        while (*p == ' ') p++;
+        if (*p == '\0') break;
+        size_t n = strcspn(p, " ");
+        int bad = 0;
+        if (n == 4 && strncmp(p, "utf8", 4) == 0)
+            tmp.utf8 = 1;
+        else if (n == 6 && strncmp(p, "sorted", 6) == 0)
+            tmp.sorted = 1;
+        else if (n == 7 && strncmp(p, "decimal", 7) == 0)
+            tmp.decimal = 1;
+        else if (n == 8 && strncmp(p, "distinct", 8) == 0)
+            tmp.distinct = 1;
+        else if (n > 6 && strncmp(p, "ngram=", 6) == 0) {
+            tmp.ngram = parse_count(p + 6, n - 6);
+            bad = tmp.ngram < 1 || tmp.ngram > WC_MAX_NGRAM;
+        }
+        else if (n > 7 && strncmp(p, "sketch=", 7) == 0) {
+            tmp.sketch = parse_count(p + 7, n - 7);
+            bad = tmp.sketch < 1 || tmp.sketch > WC_SKETCH_MAX_K;
+        }
+        else if (n > 4 && strncmp(p, "min=", 4) == 0)
+            bad = (tmp.min_len = parse_count(p + 4, n - 4)) < 0;
+        else if (n > 4 && strncmp(p, "max=", 4) == 0)
+            bad = (tmp.max_len = parse_count(p + 4, n - 4)) < 0;
+        else if (n > 7 && strncmp(p, "prefix=", 7) == 0)
+            bad = list_add(&f->prefix, &f->n_prefix, &f->cap_prefix, p + 7, n - 7) != 0;
+        else if (n > 5 && strncmp(p, "stop=", 5) == 0)
+            bad = list_add(&f->stop, &f->n_stop, &f->cap_stop, p + 5, n - 5) != 0;
+        else
+            bad = 1;
+        if (bad) {
+            filter_free(f);
+            return -1;
+        }
+        p += n;
+    }
+    if (f->n_stop == 0 && f->n_prefix == 0) {
+        filter_free(f);
+        f = NULL;
+    } else if (filter_build(f) != 0) {
+        filter_free(f);
+        return -1;
+    }
+    tmp.filter = f;
+    wc_config_free(cfg);
+    *cfg = tmp;
+    return 0;
+}
+
+void wc_config_free(WCConfig *cfg) {
+    if (!cfg) return;
+    filter_free(cfg->filter);
+    cfg->filter = NULL;
+}
+
+// Дописує " key" + value (або лише key) з обрізанням, як snprintf
+static void format_token(char *out, size_t outsize, size_t *len,
+                         const char *key, const char *value) {
+    char *dst = (*len < outsize) ? out + *len : NULL;
+    size_t room = (*len < outsize) ? outsize - *len : 0;
+    int n = dst ? snprintf(dst, room, "%s%s%s", *len ? " " : "", key, value)
+                : snprintf(NULL, 0, "%s%s%s", *len ? " " : "", key, value);
+    if (n > 0) *len += (size_t)n;
+}
+
+size_t wc_config_format(const WCConfig *cfg, char *out, size_t outsize) {
+    size_t len = 0;
+    if (outsize > 0) out[0] = '\0';
+    if (!cfg) return 0;
+    char num[16];
+    if (cfg->utf8)
+        format_token(out, outsize, &len, "utf8", "");
+    if (cfg->sorted)
+        format_token(out, outsize, &len, "sorted", "");
+    if (cfg->decimal)
+        format_token(out, outsize, &len, "decimal", "");
+    if (cfg->distinct)
+        format_token(out, outsize, &len, "distinct", "");
+    if (cfg->ngram > 1) {
+        snprintf(num, sizeof(num), "%d", cfg->ngram);
+        format_token(out, outsize, &len, "ngram=", num);
+    }
+    if (cfg->min_len > 0) {
+        snprintf(num, sizeof(num), "%d", cfg->min_len);
+        format_token(out, outsize, &len, "min=", num);
+    }
+    if (cfg->max_len > 0) {
+        snprintf(num, sizeof(num), "%d", cfg->max_len);
+        format_token(out, outsize, &len, "max=", num);
+    }
+    if (cfg->sketch > 0) {
+        snprintf(num, sizeof(num), "%d", cfg->sketch);
+        format_token(out, outsize, &len, "sketch=", num);
+    }
+    const WCFilter *f = cfg->filter;
+    for (size_t i = 0; f && i < f->n_prefix; i++)
+        format_token(out, outsize, &len, "prefix=", f->prefix[i]);
+    for (size_t i = 0; f && i < f->n_stop; i++)
+        format_token(out, outsize, &len, "stop=", f->stop[i]);
+    return len;
+}
+
+/*************************************************************
+ *   UTF-8 ТА КЛАСИФІКАЦІЯ СИМВОЛІВ
+ *************************************************************/
+
+static int is_ascii_letter(unsigned char c) {
+    return (unsigned char)((c | 0x20) - 'a') < 26;
+}
+
+/*
+ * utf8_decode: декодує один символ із s[0..avail). Повертає його
+ * довжину в байтах або 0 для невалідної послідовності (зайві
+ * довгі форми, сурогати, > U+10FFFF, обрізаний символ).
+ */
+static size_t utf8_decode(const unsigned char *s, size_t avail, uint32_t *cp) {
+    unsigned char c = s[0];
+    size_t n;
+    uint32_t min;
+    if (c < 0x80) {
+        *cp = c;
+        return 1;
+    } else if ((c & 0xE0) == 0xC0) {
+        n = 2; min = 0x80; *cp = c & 0x1F;
+    } else if ((c & 0xF0) == 0xE0) {
+        n = 3; min = 0x800; *cp = c & 0x0F;
+    } else if ((c & 0xF8) == 0xF0) {
+        n = 4; min = 0x10000; *cp = c & 0x07;
+    } else {
+        return 0;
+    }
+    if (avail < n) return 0;
+    for (size_t k = 1; k < n; k++) {
+        if ((s[k] & 0xC0) != 0x80) return 0;
+        *cp = (*cp << 6) | (s[k] & 0x3F);
+    }
+    if (*cp < min || *cp > 0x10FFFF || (*cp >= 0xD800 && *cp <= 0xDFFF))
+        return 0;
+    return n;
+}
+
+static size_t utf8_encode(uint32_t cp, char *out) {
+    if (cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    } else if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    } else if (cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Чи є символ (>= U+0080) літерою або знаком - двійковий пошук
+static int uc_is_word(uint32_t cp) {
+    size_t lo = 0;
+    size_t hi = sizeof(uc_word_ranges) / sizeof(uc_word_ranges[0]);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (cp < uc_word_ranges[mid][0])
+            hi = mid;
+        else if (cp > uc_word_ranges[mid][1])
+            lo = mid + 1;
+        else
+            return 1;
+    }
+    return 0;
+}
+
+// Проста згортка регістру (>= U+0080)
+static uint32_t uc_fold(uint32_t cp) {
+    size_t lo = 0;
+    size_t hi = sizeof(uc_fold_runs) / sizeof(uc_fold_runs[0]);
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        const UcFoldRun *r = &uc_fold_runs[mid];
+        if (cp < r->lo)
+            hi = mid;
+        else if (cp > r->hi)
+            lo = mid + 1;
+        else
+            return ((cp - r->lo) % r->stride == 0) ? (uint32_t)((int32_t)cp + r->delta) : cp;
+    }
+    return cp;
+}
+
+/*
+ * ascii_block: класифікує 16 байтів за раз. Повертає маску
+ * літер ASCII (біт i - байт i), у lower пише байти, де літери
+ * переведено в нижній регістр, у high - маску байтів >= 0x80,
+ * в upper - маску великих літер.
+ */
+#if defined(__SSE2__)
+static unsigned ascii_block(const unsigned char *p, unsigned char *lower,
+                            unsigned *high, unsigned *upper) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    // Байти >= 0x80 відʼємні у знаковому порівнянні, тож не літери
+    __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)),
+                                   _mm_cmplt_epi8(folded, _mm_set1_epi8('z' + 1)));
+    __m128i low = _mm_or_si128(v, _mm_and_si128(letter, _mm_set1_epi8(0x20)));
+    _mm_storeu_si128((__m128i *)lower, low);
+    *high = (unsigned)_mm_movemask_epi8(v);
+    *upper = ~(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, low)) & 0xFFFFu;
+    return (unsigned)_mm_movemask_epi8(letter);
+}
+#else
+static unsigned ascii_block(const unsigned char *p, unsigned char *lower,
+                            unsigned *high, unsigned *upper) {
+    unsigned mask = 0;
+    *high = 0;
+    *upper = 0;
+    for (int k = 0; k < 16; k++) {
+        int letter = is_ascii_letter(p[k]);
+        lower[k] = letter ? (unsigned char)(p[k] | 0x20) : p[k];
+        mask |= (unsigned)letter << k;
+        *high |= (unsigned)(p[k] >> 7) << k;
+        *upper |= (unsigned)(lower[k] != p[k]) << k;
+    }
+    return mask;
+}
+#endif
+
+/*************************************************************
+ *   ТОКЕНІЗАТОР
+ *************************************************************/
+
+/*
+ * wc_tokenize: блоки по 16 байт класифікуються за раз
+ * (ascii_block). Слово, що вже в нижньому регістрі, передається
+ * відрізком самого тексту; у буфер (на стеку, якщо текст не
+ * довший за кадр) копіюється лише слово з великими літерами чи
+ * символами, які згортаються. У режимі UTF-8 блок із байтами
+ * >= 0x80 обробляється посимвольно до свого кінця (scalar_end;
+ * символ на межі дочитується цілим), а далі знову блоками.
+ */
+#define WORD_STACK_SIZE (2 * 1500 + 1) // Згорнутий кадр до 1500 байт
+
+// Переносить уже набраний відрізок слова в буфер
+#define COPY_WORD()                             \
+    do {                                        \
+        if (!copied) {                          \
+            memcpy(word, text + wstart, wlen);  \
+            copied = 1;                         \
+        }                                       \
+    } while (0)
+
+#define FLUSH_WORD()                                        \
+    do {                                                    \
+        if (wlen > 0) {                                     \
+            fn(copied ? word : text + wstart, wlen, ctx);   \
+            words++;                                        \
+            wlen = 0;                                       \
+            copied = 0;                                     \
+        }                                                   \
+    } while (0)
+
+long wc_tokenize(const char *text, size_t len, const WCConfig *cfg,
+                 wc_word_fn fn, void *ctx) {
+    int utf8 = cfg && cfg->utf8;
+    // Згорнутий символ UTF-8 може бути довшим за вихідний (до 3/2)
+    char stack_word[WORD_STACK_SIZE];
+    char *word = stack_word;
+    if (2 * len + 1 > sizeof(stack_word)) {
+        word = malloc(2 * len + 1);
+        if (!word) return -1;
+    }
+    const unsigned char *s = (const unsigned char *)text;
+    long words = 0;
+    size_t wlen = 0;
+    size_t wstart = 0;      // Початок слова в тексті, поки !copied
+    int copied = 0;         // Слово вже в буфері word
+    size_t i = 0;
+    size_t scalar_end = 0;  // Кінець блоку з UTF-8, що йде посимвольно
+    while (i < len) {
+        if (i >= scalar_end && len - i >= 16) {
+            unsigned char lower[16];
+            unsigned high, upper;
+            unsigned mask = ascii_block(s + i, lower, &high, &upper);
+            if (!utf8 || high == 0) {
+                unsigned j = 0;
+                while (j < 16) {
+                    unsigned rest = mask >> j;
+                    if (rest & 1) {
+                        // Відрізок літер (біти вище 16 нульові, тож ~rest обмежує його)
+                        unsigned run = (unsigned)__builtin_ctz(~rest);
+                        if (wlen == 0)
+                            wstart = i + j;
+                        if (!copied && ((upper >> j) & ((1u << run) - 1)))
+                            COPY_WORD();
+                        if (copied)
+                            memcpy(word + wlen, lower + j, run);
+                        wlen += run;
+                        j += run;
+                    } else {
+                        FLUSH_WORD();
+                        j = rest ? j + (unsigned)__builtin_ctz(rest) : 16;
+                    }
+                }
+                i += 16;
+                continue;
+            }
+            scalar_end = i + 16;
+        }
+
+        // Посимвольно: хвіст коротший за блок або символи UTF-8
+        unsigned char c = s[i];
+        if (c < 0x80 || !utf8) {
+            if (is_ascii_letter(c)) {
+                if (wlen == 0)
+                    wstart = i;
+                if (!(c & 0x20))
+                    COPY_WORD();
+                if (copied)
+                    word[wlen] = (char)(c | 0x20);
+                wlen++;
+            } else {
+                FLUSH_WORD();
+            }
+            i++;
+            continue;
+        }
+        uint32_t cp;
+        size_t n = utf8_decode(s + i, len - i, &cp);
+        if (n == 0) {
+            FLUSH_WORD();       // Невалідний байт - роздільник
+            i++;
+        } else {
+            if (uc_is_word(cp)) {
+                if (wlen == 0)
+                    wstart = i;
+                // Незгорнутий символ збігається зі своїми байтами в тексті
+                uint32_t folded = uc_fold(cp);
+                if (folded != cp)
+                    COPY_WORD();
+                if (copied)
+                    wlen += utf8_encode(folded, word + wlen);
+                else
+                    wlen += n;
+            } else {
+                FLUSH_WORD();
+            }
+            i += n;
+        }
+    }
+    FLUSH_WORD();
+    if (word != stack_word)
+        free(word);
+    return words;
+}
+
+#undef COPY_WORD
+#undef FLUSH_WORD
+
+typedef struct CountCtx {
+    WCMap *map;
+    const WCConfig *cfg;
+    int failed;
+} CountCtx;
+
+static void count_word(const char *word, size_t len, void *ctx) {
+    CountCtx *cc = ctx;
+    if (!wc_word_accepted(cc->cfg, word, len))
+        return;
+    // Хеш рахується один раз на токен і зберігається у вузлі
+    uint64_t hash = wc_hash64(word, len, cc->map->seed);
+    if (wc_map_add_hashed(cc->map, word, len, hash, 1) != 0)
+        cc->failed = 1;
+}
+
+long wc_count_text(WCMap *map, const char *text, size_t len, const WCConfig *cfg) {
+    CountCtx cc = { map, cfg, 0 };
+    long words = wc_tokenize(text, len, cfg, count_word, &cc);
+    return cc.failed ? -1 : words;
+}
+
+typedef struct NormalizeCtx {
+    char *out;
+    size_t len;
+} NormalizeCtx;
+
+static void append_word(const char *word, size_t len, void *ctx) {
+    NormalizeCtx *nc = ctx;
+    if (nc->len > 0)
+        nc->out[nc->len++] = ' ';
+    memcpy(nc->out + nc->len, word, len);
+    nc->len += len;
+}
+
+long wc_normalize(const char *text, size_t len, const WCConfig *cfg, char *out) {
+    NormalizeCtx nc = { out, 0 };
+    if (wc_tokenize(text, len, cfg, append_word, &nc) < 0)
+        return -1;
+    out[nc.len] = '\0';
+    return (long)nc.len;
+}
+
+/*************************************************************
+ *   N-ГРАМИ
+ *
+ *  Вікно з n-1 останніх слів (після фільтрів) ковзає по тексту;
+ *  кожне наступне слово утворює n-граму "w1 w2 ... wn" (слова
+ *  через пробіл). Слова контексту лише заповнюють вікно, тож
+ *  n-грама, що перетинає межу частин, рахується один раз - у
+ *  частині, де її останнє слово.
+ *************************************************************/
+typedef struct NgramCtx {
+    wc_word_fn emit;            // NULL: лише заповнювати вікно
+    void *emit_ctx;
+    const WCConfig *cfg;
+    char *win[WC_MAX_NGRAM];    // Останні слова (власні копії)
+    int n_win;
+    int failed;
+} NgramCtx;
+
+static void ngram_word(const char *word, size_t len, void *ctx) {
+    NgramCtx *nc = ctx;
+    int n = nc->cfg->ngram;
+    if (!wc_word_accepted(nc->cfg, word, len))
+        return;
+    if (nc->emit && nc->n_win == n - 1) {
+        size_t klen = len;
+        for (int i = 0; i < nc->n_win; i++)
+            klen += strlen(nc->win[i]) + 1;
+        char stack_key[512];
+        char *key = (klen < sizeof(stack_key)) ? stack_key : malloc(klen + 1);
+        if (!key) {
+            nc->failed = 1;
+            return;
+        }
+        size_t pos = 0;
+        for (int i = 0; i < nc->n_win; i++) {
+            size_t wl = strlen(nc->win[i]);
+            memcpy(key + pos, nc->win[i], wl);
+            pos += wl;
+            key[pos++] = ' ';
+        }
+        memcpy(key + pos, word, len);
+        key[klen] = '\0';
+        nc->emit(key, klen, nc->emit_ctx);
+        if (key != stack_key)
+            free(key);
+    }
+    char *copy = malloc(len + 1);
+    if (!copy) {
+        nc->failed = 1;
+        return;
+    }
+    memcpy(copy, word, len);
+    copy[len] = '\0';
+    if (nc->n_win == n - 1) {
+        free(nc->win[0]);
+        memmove(nc->win, nc->win + 1, (nc->n_win - 1) * sizeof(char *));
+        nc->n_win--;
+    }
+    nc->win[nc->n_win++] = copy;
+}
+
+static void ngram_free(NgramCtx *nc) {
+    for (int i = 0; i < nc->n_win; i++)
+        free(nc->win[i]);
+    nc->n_win = 0;
+}
+
+size_t wc_ngram_context(const char *text, size_t len, const WCConfig *cfg,
+                        char *out, size_t outsize) {
+    if (outsize == 0) return 0;
+    out[0] = '\0';
+    if (!cfg || cfg->ngram < 2) return 0;
+    NgramCtx nc = { NULL, NULL, cfg, { NULL }, 0, 0 };
+    size_t pos = 0;
+    if (wc_tokenize(text, len, cfg, ngram_word, &nc) >= 0 && !nc.failed) {
+        size_t need = 0;
+        for (int i = 0; i < nc.n_win; i++)
+            need += strlen(nc.win[i]) + (i > 0);
+        // Контекст, що не вміщується, не передається зовсім
+        for (int i = 0; need < outsize && i < nc.n_win; i++)
+            pos += snprintf(out + pos, outsize - pos, "%s%s", i ? " " : "", nc.win[i]);
+    }
+    ngram_free(&nc);
+    return pos;
+}
+
+typedef struct FilterCtx {
+    const WCConfig *cfg;
+    wc_word_fn fn;
+    void *ctx;
+} FilterCtx;
+
+static void accepted_word(const char *word, size_t len, void *ctx) {
+    FilterCtx *fc = ctx;
+    if (wc_word_accepted(fc->cfg, word, len))
+        fc->fn(word, len, fc->ctx);
+}
+
+/*
+ * each_chunk_token: викликає fn для всього, що рахує
+ * wc_count_chunk: слів частини, які пройшли фільтри, або її
+ * n-грам (з контекстом із заголовка). Повертає к-сть слів або -1.
+ */
+static long each_chunk_token(const char *chunk, size_t len, const WCConfig *cfg,
+                             wc_word_fn fn, void *ctx) {
+    if (!cfg || cfg->ngram < 2) {
+        FilterCtx fc = { cfg, fn, ctx };
+        return wc_tokenize(chunk, len, cfg, accepted_word, &fc);
+    }
+
+    // Заголовок "<L>:" і L байтів контексту
+    size_t i = 0, ctx_len = 0;
+    while (i < len && i < 6 && isdigit((unsigned char)chunk[i]))
+        ctx_len = ctx_len * 10 + (size_t)(chunk[i++] - '0');
+    if (i == 0 || i >= len || chunk[i] != ':' || ctx_len > len - i - 1) {
+        i = 0;          // Без заголовка: увесь текст без контексту
+        ctx_len = 0;
+    } else {
+        i++;
+    }
+
+    NgramCtx nc = { NULL, NULL, cfg, { NULL }, 0, 0 };
+    long words = 0;
+    if (ctx_len > 0)
+        words = wc_tokenize(chunk + i, ctx_len, cfg, ngram_word, &nc);
+    nc.emit = fn;
+    nc.emit_ctx = ctx;
+    if (words >= 0)
+        words = wc_tokenize(chunk + i + ctx_len, len - i - ctx_len, cfg, ngram_word, &nc);
+    ngram_free(&nc);
+    return (words < 0 || nc.failed) ? -1 : words;
+}
+
+static void count_key(const char *key, size_t len, void *ctx) {
+    CountCtx *cc = ctx;
+    (void)len;
+    if (wc_map_add(cc->map, key, 1) != 0)
+        cc->failed = 1;
+}
+
+long wc_count_chunk(WCMap *map, const char *chunk, size_t len, const WCConfig *cfg) {
+    if (!cfg || cfg->ngram < 2)
+        return wc_count_text(map, chunk, len, cfg);
+    CountCtx cc = { map, cfg, 0 };
+    long words = each_chunk_token(chunk, len, cfg, count_key, &cc);
+    return cc.failed ? -1 : words;
+}
+
+/*************************************************************
+ *   МЕЖІ ЧАСТИН
+ *************************************************************/
+
+// Маска байтів-меж (ASCII, але не літера) у блоці з 16 байтів
+static unsigned boundary_block(const unsigned char *p) {
+    unsigned char lower[16];
+    unsigned high, upper;
+    unsigned letters = ascii_block(p, lower, &high, &upper);
+    return ~(letters | high) & 0xFFFFu;
+}
+
+static int is_boundary(unsigned char c) {
+    return c < 0x80 && !is_ascii_letter(c);
+}
+
+/*
+ * wc_chunk_cut: спершу перевіряє text[max] (різ перед межею),
+ * потім шукає останню межу в text[0..max) блоками по 16 байт
+ * з кінця.
+ */
+size_t wc_chunk_cut(const char *text, size_t len, size_t max) {
+    const unsigned char *s = (const unsigned char *)text;
+    if (max > len) max = len;
+    if (max < len && is_boundary(s[max]))
+        return max;
+    size_t end = max;
+    while (end >= 16) {
+        unsigned mask = boundary_block(s + end - 16);
+        if (mask)
+            return end - 16 + (size_t)(31 - __builtin_clz(mask)) + 1;
+        end -= 16;
+    }
+    while (end > 0) {
+        if (is_boundary(s[end - 1]))
+            return end;
+        end--;
+    }
+    return 0;
+}
+
+size_t wc_skip_separators(const char *text, size_t len) {
+    const unsigned char *s = (const unsigned char *)text;
+    size_t i = 0;
+    while (len - i >= 16) {
+        unsigned other = ~boundary_block(s + i) & 0xFFFFu;
+        if (other)
+            return i + (size_t)__builtin_ctz(other);
+        i += 16;
+    }
+    while (i < len && is_boundary(s[i]))
+        i++;
+    return i;
+}
+
+/*************************************************************
+ *   ЯДРА MAP / REDUCE
+ *************************************************************/
+
+/*
+ * emit_unary: дописує "word111..." у out з позиції *idx. Повертає
+ * 0, якщо місце закінчилось (далі нічого не пишемо).
+ */
+static int emit_unary(const char *word, size_t key_len, int count,
+                      char *out, size_t *idx, size_t outsize) {
+    // Перевіряємо, чи вистачить місця
+    if (*idx + key_len >= outsize - 1)
+        return 0;
+    memcpy(out + *idx, word, key_len);
+    *idx += key_len;
+    // Додаємо count разів '1'
+    for (int j = 0; j < count && *idx < outsize - 1; j++)
+        out[(*idx)++] = '1';
+    return 1;
+}
+
+// Те саме для "word<count>" (десяткове число)
+static int emit_decimal(const char *word, size_t key_len, int count,
+                        char *out, size_t *pos, size_t outsize) {
+    if (*pos + key_len >= outsize - 1)
+        return 0;
+    memcpy(out + *pos, word, key_len);
+    *pos += key_len;
+    char nbuffer[32];
+    size_t num_len = (size_t)snprintf(nbuffer, sizeof(nbuffer), "%d", count);
+    if (*pos + num_len >= outsize - 1)
+        return 0;
+    memcpy(out + *pos, nbuffer, num_len);
+    *pos += num_len;
+    return 1;
+}
+
+/*
+ * wc_map_kernel: рахує слова тексту й записує їх за порядком
+ * першої появи (або за зростанням, якщо cfg->sorted): слово, а
+ * за ним стільки '1', скільки разів воно трапилось.
+ */
+size_t wc_map_kernel(const char *text, const WCConfig *cfg, char *out, size_t outsize) {
+    return wc_map_kernel_len(text, strlen(text), cfg, out, outsize);
+}
+
+size_t wc_map_kernel_len(const char *text, size_t len, const WCConfig *cfg,
+                         char *out, size_t outsize) {
+    if (outsize == 0) return 0;
+    size_t idx = 0;
+    WCMap *map = wc_map_create();
+    if (map && wc_count_chunk(map, text, len, cfg) >= 0) {
+        if (cfg && cfg->sorted) {
+            WCNode **sorted = wc_map_sorted(map);
+            for (size_t k = 0; sorted && k < map->size; k++) {
+                if (!emit_unary(sorted[k]->word, sorted[k]->len, sorted[k]->count,
+                                out, &idx, outsize))
+                    break;
+            }
+            free(sorted);
+        } else {
+            for (WCNode *curr = map->order_head; curr; curr = curr->order_next) {
+                if (!emit_unary(curr->word, curr->len, curr->count,
+                                out, &idx, outsize))
+                    break;
+            }
+        }
+    }
+    out[idx] = '\0';
+    wc_map_free(map);
+    return idx;
+}
+
+/*
+ * wc_reduce_kernel: розбирає "word111word1..." (слово - будь-які
+ * байти, крім цифр, + '1' на кожне входження; з cfg->decimal -
+ * "word12word3..."), сумує однакові слова й записує "word<число>"
+ * за порядком першої появи. Слова, довші за WC_WORD_MAX байтів,
+ * обрізаються (wc_word_clip).
+ */
+size_t wc_reduce_kernel(const char *payload, const WCConfig *cfg,
+                        char *out, size_t outsize) {
+    return wc_reduce_kernel_len(payload, strlen(payload), cfg, out, outsize);
+}
+
+/*
+ * digit_block: маска цифр ASCII у 16 байтах (біт i - байт i), у
+ * ones - маска байтів '1'.
+ */
+#if defined(__SSE2__)
+static unsigned digit_block(const unsigned char *p, unsigned *ones) {
+    __m128i v = _mm_loadu_si128((const __m128i *)p);
+    *ones = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('1')));
+    // Байти >= 0x80 відʼємні у знаковому порівнянні, тож не цифри
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                                  _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+    return (unsigned)_mm_movemask_epi8(digit);
+}
+#else
+static unsigned digit_block(const unsigned char *p, unsigned *ones) {
+    unsigned mask = 0;
+    *ones = 0;
+    for (int k = 0; k < 16; k++) {
+        mask |= (unsigned)(p[k] >= '0' && p[k] <= '9') << k;
+        *ones |= (unsigned)(p[k] == '1') << k;
+    }
+    return mask;
+}
+#endif
+
+size_t wc_word_span(const char *text, size_t len) {
+    const unsigned char *s = (const unsigned char *)text;
+    size_t i = 0;
+    while (len - i >= 16) {
+        unsigned ones;
+        unsigned digits = digit_block(s + i, &ones);
+        if (digits)
+            return i + (size_t)__builtin_ctz(digits);
+        i += 16;
+    }
+    while (i < len && !isdigit(s[i]))
+        i++;
+    return i;
+}
+
+size_t wc_word_clip(const char *word, size_t len) {
+    if (len <= WC_WORD_MAX)
+        return len;
+    len = WC_WORD_MAX;
+    while (len > 0 && ((unsigned char)word[len] & 0xC0) == 0x80)
+        len--;
+    return len;
+}
+
+size_t wc_ones_span(const char *text, size_t len) {
+    const unsigned char *s = (const unsigned char *)text;
+    size_t i = 0;
+    while (len - i >= 16) {
+        unsigned ones;
+        digit_block(s + i, &ones);
+        unsigned other = ~ones & 0xFFFFu;
+        if (other)
+            return i + (size_t)__builtin_ctz(other);
+        i += 16;
+    }
+    while (i < len && s[i] == '1')
+        i++;
+    return i;
+}
+
+// Викликається для кожної пари "слово + лічильник" у payload;
+// word - відрізок payload (без '\0' у кінці)
+typedef void (*pair_fn)(const char *word, size_t len, int count, void *ctx);
+
+static void parse_payload(const char *payload, size_t n, int decimal,
+                          pair_fn fn, void *ctx) {
+    size_t i = 0;
+    while (i < n) {
+        size_t start = i;
+        // Слово - усе до першої цифри
+        size_t word_len = wc_word_span(payload + i, n - i);
+        const char *word = payload + i;
+        i += word_len;
+        word_len = wc_word_clip(word, word_len);
+
+        // Лічимо '1' (або десяткове число)
+        int count = 0;
+        if (decimal) {
+            while (i < n && isdigit((unsigned char)payload[i]))
+                count = count * 10 + (payload[i++] - '0');
+        } else {
+            size_t run = wc_ones_span(payload + i, n - i);
+            count = (int)run;
+            i += run;
+        }
+
+        if (word_len > 0 && count > 0)
+            fn(word, word_len, count, ctx);
+        if (i == start)
+            i++; // Невідомий байт: пропускаємо, щоб не зациклитись
+    }
+}
+
+static void map_pair(const char *word, size_t len, int count, void *ctx) {
+    WCMap *map = ctx;
+    wc_map_add_hashed(map, word, len, wc_hash64(word, len, map->seed), count);
+}
+
+size_t wc_reduce_kernel_len(const char *payload, size_t n, const WCConfig *cfg,
+                            char *out, size_t outsize) {
+    if (outsize == 0) return 0;
+    size_t pos = 0;
+    WCMap *map = wc_map_create();
+    if (!map) {
+        out[0] = '\0';
+        return 0;
+    }
+    parse_payload(payload, n, cfg && cfg->decimal, map_pair, map);
+    for (WCNode *curr = map->order_head; curr; curr = curr->order_next) {
+        if (!emit_decimal(curr->word, curr->len, curr->count, out, &pos, outsize))
+            break;
+    }
+    out[pos] = '\0';
+    wc_map_free(map);
+    return pos;
+}
+
+/*************************************************************
+ *   СЛОВНИК НОМЕРІВ СЛІВ
+ *
+ *  Слова лежать одне за одним у data (через '\0'), таблиця з
+ *  відкритою адресацією веде від хешу до номера. Лічильники
+ *  запиту - щільний масив counts за номером; order - номери за
+ *  порядком першої появи в запиті, за ним лічильники й
+ *  обнуляються наприкінці.
+ *************************************************************/
+typedef struct InternSlot {
+    uint32_t id;                // Номер + 1 (0 - вільна комірка)
+    uint32_t hash;
+} InternSlot;
+
+struct WCIntern {
+    char *data;
+    size_t data_len;
+    size_t data_cap;
+    size_t *offs;               // Зсув слова в data за номером
+    uint32_t *lens;             // Довжина слова за номером
+    int *counts;                // Лічильники поточного запиту за номером
+    uint32_t *order;            // Номери за порядком першої появи
+    size_t n_order;
+    size_t n_words;
+    size_t cap_words;
+    InternSlot *slots;
+    size_t n_slots;             // Степінь двійки; слів не більше половини
+    size_t max_words;
+    uint64_t seed;
+};
+
+static long intern_insert(WCIntern *in, const char *word, size_t len);
+
+// Часті слова займають номери 0..WC_COMMON_WORDS-1 (як у wc_common_word)
+static int intern_preload(WCIntern *in) {
+    for (int id = 0; id < WC_COMMON_WORDS; id++) {
+        const char *word = wc_common_word_text(id);
+        if (intern_insert(in, word, strlen(word)) != id)
+            return -1;
+    }
+    return 0;
+}
+
+WCIntern *wc_intern_create(size_t max_words) {
+    WCIntern *in = calloc(1, sizeof(WCIntern));
+    if (!in) return NULL;
+    in->n_slots = WC_HASH_SIZE;
+    in->slots = calloc(in->n_slots, sizeof(InternSlot));
+    in->max_words = max_words;
+    in->seed = map_seed(in);
+    if (!in->slots || intern_preload(in) != 0) {
+        wc_intern_free(in);
+        return NULL;
+    }
+    return in;
+}
+
+void wc_intern_free(WCIntern *in) {
+    if (!in) return;
+    free(in->data);
+    free(in->offs);
+    free(in->lens);
+    free(in->counts);
+    free(in->order);
+    free(in->slots);
+    free(in);
+}
+
+void wc_intern_clear(WCIntern *in) {
+    for (size_t k = 0; k < in->n_order; k++)
+        in->counts[in->order[k]] = 0;
+    in->n_order = 0;
+    in->n_words = 0;
+    in->data_len = 0;
+    memset(in->slots, 0, in->n_slots * sizeof(InternSlot));
+    intern_preload(in);     // Памʼять під них уже є
+}
+
+static int intern_grow_slots(WCIntern *in) {
+    size_t n = in->n_slots * 2;
+    InternSlot *slots = calloc(n, sizeof(InternSlot));
+    if (!slots) return -1;
+    for (size_t i = 0; i < in->n_slots; i++) {
+        if (!in->slots[i].id) continue;
+        size_t j = in->slots[i].hash & (n - 1);
+        while (slots[j].id)
+            j = (j + 1) & (n - 1);
+        slots[j] = in->slots[i];
+    }
+    free(in->slots);
+    in->slots = slots;
+    in->n_slots = n;
+    return 0;
+}
+
+// Місце ще для одного слова довжини len (масиви за номером і data)
+static int intern_reserve(WCIntern *in, size_t len) {
+    if ((in->n_words + 1) * 2 > in->n_slots && intern_grow_slots(in) != 0)
+        return -1;
+    if (in->data_len + len + 1 > in->data_cap) {
+        size_t cap = in->data_cap ? in->data_cap * 2 : 65536;
+        while (cap < in->data_len + len + 1) cap *= 2;
+        char *data = realloc(in->data, cap);
+        if (!data) return -1;
+        in->data = data;
+        in->data_cap = cap;
+    }
+    if (in->n_words == in->cap_words) {
+        size_t cap = in->cap_words ? in->cap_words * 2 : 4096;
+        size_t *offs = realloc(in->offs, cap * sizeof(size_t));
+        if (offs) in->offs = offs;
+        uint32_t *lens = realloc(in->lens, cap * sizeof(uint32_t));
+        if (lens) in->lens = lens;
+        int *counts = realloc(in->counts, cap * sizeof(int));
+        if (counts) in->counts = counts;
+        uint32_t *order = realloc(in->order, cap * sizeof(uint32_t));
+        if (order) in->order = order;
+        if (!offs || !lens || !counts || !order) return -1;
+        memset(in->counts + in->cap_words, 0, (cap - in->cap_words) * sizeof(int));
+        in->cap_words = cap;
+    }
+    return 0;
+}
+
+long wc_intern_id(WCIntern *in, const char *word, size_t len) {
+    // Часте слово: номер без проб і порівнянь у таблиці
+    int common = wc_common_word(word, len);
+    if (common >= 0)
+        return common;
+    return intern_insert(in, word, len);
+}
+
+static long intern_insert(WCIntern *in, const char *word, size_t len) {
+    uint64_t h64 = wc_hash64(word, len, in->seed);
+    uint32_t h = (uint32_t)(h64 ^ (h64 >> 32));
+    size_t mask = in->n_slots - 1;
+    size_t i = h & mask;
+    for (; in->slots[i].id; i = (i + 1) & mask) {
+        uint32_t id = in->slots[i].id - 1;
+        if (in->slots[i].hash == h && in->lens[id] == len &&
+            memcmp(in->data + in->offs[id], word, len) == 0)
+            return id;
+    }
+    if (intern_reserve(in, len) != 0)
+        return -1;
+    if (mask != in->n_slots - 1) {
+        // Таблиця виросла: шукаємо вільну комірку заново
+        mask = in->n_slots - 1;
+        for (i = h & mask; in->slots[i].id; i = (i + 1) & mask)
+            ;
+    }
+    size_t id = in->n_words++;
+    in->offs[id] = in->data_len;
+    in->lens[id] = (uint32_t)len;
+    memcpy(in->data + in->data_len, word, len);
+    in->data[in->data_len + len] = '\0';
+    in->data_len += len + 1;
+    in->slots[i].id = (uint32_t)id + 1;
+    in->slots[i].hash = h;
+    return (long)id;
+}
+
+typedef struct InternCtx {
+    WCIntern *in;
+    const WCConfig *cfg;
+    int failed;
+} InternCtx;
+
+static void intern_pair(const char *word, size_t len, int count, void *ctx) {
+    InternCtx *ic = ctx;
+    long id = wc_intern_id(ic->in, word, len);
+    if (id < 0) {
+        ic->failed = 1;
+        return;
+    }
+    if (ic->in->counts[id] == 0)
+        ic->in->order[ic->in->n_order++] = (uint32_t)id;
+    ic->in->counts[id] += count;
+}
+
+static void intern_word(const char *word, size_t len, void *ctx) {
+    InternCtx *ic = ctx;
+    if (wc_word_accepted(ic->cfg, word, len))
+        intern_pair(word, len, 1, ic);
+}
+
+// Переповнений словник очищається лише між запитами
+static void intern_begin(WCIntern *in) {
+    if (in->n_words >= in->max_words)
+        wc_intern_clear(in);
+}
+
+// Обнуляє лічильники запиту
+static void intern_end(WCIntern *in) {
+    for (size_t k = 0; k < in->n_order; k++)
+        in->counts[in->order[k]] = 0;
+    in->n_order = 0;
+}
+
+typedef struct InternEntry {
+    const char *word;           // Слово в data (завершене '\0')
+    uint32_t id;
+} InternEntry;
+
+static int cmp_entry_word(const void *a, const void *b) {
+    return strcmp(((const InternEntry *)a)->word, ((const InternEntry *)b)->word);
+}
+
+size_t wc_map_kernel_intern(WCIntern *in, const char *text, size_t len,
+                            const WCConfig *cfg, char *out, size_t outsize) {
+    if (!in || (cfg && cfg->ngram > 1))
+        return wc_map_kernel_len(text, len, cfg, out, outsize);
+    if (outsize == 0) return 0;
+    size_t idx = 0;
+    intern_begin(in);
+    InternCtx ic = { in, cfg, 0 };
+    if (wc_tokenize(text, len, cfg, intern_word, &ic) >= 0 && !ic.failed) {
+        if (cfg && cfg->sorted) {
+            InternEntry *words = malloc((in->n_order ? in->n_order : 1) * sizeof(InternEntry));
+            for (size_t k = 0; words && k < in->n_order; k++)
+                words[k] = (InternEntry){ in->data + in->offs[in->order[k]], in->order[k] };
+            if (words)
+                qsort(words, in->n_order, sizeof(InternEntry), cmp_entry_word);
+            for (size_t k = 0; words && k < in->n_order; k++) {
+                uint32_t id = words[k].id;
+                if (!emit_unary(words[k].word, in->lens[id], in->counts[id], out, &idx, outsize))
+                    break;
+            }
+            free(words);
+        } else {
+            for (size_t k = 0; k < in->n_order; k++) {
+                uint32_t id = in->order[k];
+                if (!emit_unary(in->data + in->offs[id], in->lens[id], in->counts[id],
+                                out, &idx, outsize))
+                    break;
+            }
+        }
+    }
+    intern_end(in);
+    out[idx] = '\0';
+    return idx;
+}
+
+size_t wc_reduce_kernel_intern(WCIntern *in, const char *payload, size_t n,
+                               const WCConfig *cfg, char *out, size_t outsize) {
+    if (!in)
+        return wc_reduce_kernel_len(payload, n, cfg, out, outsize);
+    if (outsize == 0) return 0;
+    size_t pos = 0;
+    intern_begin(in);
+    InternCtx ic = { in, cfg, 0 };
+    parse_payload(payload, n, cfg && cfg->decimal, intern_pair, &ic);
+    for (size_t k = 0; k < in->n_order; k++) {
+        uint32_t id = in->order[k];
+        if (!emit_decimal(in->data + in->offs[id], in->lens[id], in->counts[id],
+                          out, &pos, outsize))
+            break;
+    }
+    intern_end(in);
+    out[pos] = '\0';
+    return pos;
+}
+
+/*************************************************************
+ *   СКЕТЧ ЧАСТОТ (Count-Min + Space-Saving)
+ *
+ *  Space-Saving - мін-купа з K кандидатів за count і таблиця з
+ *  відкритою адресацією (слово -> позиція в купі). Нове слово
+ *  при повній купі витісняє мінімальне й успадковує його count
+ *  як похибку. Злиття - за Agarwal et al. ("Mergeable
+ *  Summaries"): кандидату, відсутньому в повному скетчі,
+ *  додається мінімум того скетчу, після чого лишаються K
+ *  найбільших.
+ *************************************************************/
+#define SKETCH_MAGIC "WCSK"
+#define SKETCH_SEED 0x736b657463680000ULL
+
+struct WCSketch {
+    uint64_t *cm;               // WC_CM_DEPTH рядків по WC_CM_WIDTH
+    uint64_t total;
+    WCHeavy *heap;              // Мін-купа за count, n із k
+    size_t *slot_of;            // Комірка index для кожної позиції купи
+    size_t k, n;
+    int32_t *index;             // Позиція в купі або -1
+    size_t n_index;             // Степінь двійки, щонайменше 2k
+};
+
+static uint64_t sketch_hash(const char *word, size_t len) {
+    return filter_hash(word, len, SKETCH_SEED);
+}
+
+// Комірка рядка row: подвійне хешування (Kirsch-Mitzenmacher)
+static size_t cm_cell(uint64_t h, int row) {
+    uint32_t h1 = (uint32_t)h;
+    uint32_t h2 = (uint32_t)(h >> 32) | 1;
+    return (size_t)row * WC_CM_WIDTH + ((h1 + (uint32_t)row * h2) & (WC_CM_WIDTH - 1));
+}
+
+WCSketch *wc_sketch_create(size_t k) {
+    if (k == 0 || k > WC_SKETCH_MAX_K) return NULL;
+    WCSketch *sk = calloc(1, sizeof(WCSketch));
+    if (!sk) return NULL;
+    sk->k = k;
+    sk->n_index = 16;
+    while (sk->n_index < 2 * k)
+        sk->n_index *= 2;
+    sk->cm = calloc((size_t)WC_CM_DEPTH * WC_CM_WIDTH, sizeof(uint64_t));
+    sk->heap = calloc(k, sizeof(WCHeavy));
+    sk->slot_of = calloc(k, sizeof(size_t));
+    sk->index = malloc(sk->n_index * sizeof(int32_t));
+    if (!sk->cm || !sk->heap || !sk->slot_of || !sk->index) {
+        wc_sketch_free(sk);
+        return NULL;
+    }
+    memset(sk->index, 0xff, sk->n_index * sizeof(int32_t));
+    return sk;
+}
+
+void wc_sketch_free(WCSketch *sk) {
+    if (!sk) return;
+    for (size_t i = 0; i < sk->n; i++)
+        free(sk->heap[i].word);
+    free(sk->cm);
+    free(sk->heap);
+    free(sk->slot_of);
+    free(sk->index);
+    free(sk);
+}
+
+// Комірка index зі словом або порожня комірка, куди його вставити
+static size_t ss_probe(const WCSketch *sk, const char *word, size_t len, uint64_t h) {
+    size_t mask = sk->n_index - 1;
+    size_t i = (size_t)h & mask;
+    while (sk->index[i] >= 0) {
+        const char *w = sk->heap[sk->index[i]].word;
+        if (strncmp(w, word, len) == 0 && w[len] == '\0')
+            break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static void ss_swap(WCSketch *sk, size_t a, size_t b) {
+    WCHeavy t = sk->heap[a];
+    sk->heap[a] = sk->heap[b];
+    sk->heap[b] = t;
+    size_t s = sk->slot_of[a];
+    sk->slot_of[a] = sk->slot_of[b];
+    sk->slot_of[b] = s;
+    sk->index[sk->slot_of[a]] = (int32_t)a;
+    sk->index[sk->slot_of[b]] = (int32_t)b;
+}
+
+static void ss_sift_up(WCSketch *sk, size_t i) {
+    while (i > 0 && sk->heap[(i - 1) / 2].count > sk->heap[i].count) {
+        ss_swap(sk, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void ss_sift_down(WCSketch *sk, size_t i) {
+    for (;;) {
+        size_t m = i, l = 2 * i + 1, r = 2 * i + 2;
+        if (l < sk->n && sk->heap[l].count < sk->heap[m].count) m = l;
+        if (r < sk->n && sk->heap[r].count < sk->heap[m].count) m = r;
+        if (m == i) return;
+        ss_swap(sk, i, m);
+        i = m;
+    }
+}
+
+// Звільняє комірку index зі зсувом наступних назад (без надгробків)
+static void ss_unindex(WCSketch *sk, size_t slot) {
+    size_t mask = sk->n_index - 1;
+    size_t i = slot, j = slot;
+    sk->index[i] = -1;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (sk->index[j] < 0) return;
+        const char *w = sk->heap[sk->index[j]].word;
+        size_t home = (size_t)sketch_hash(w, strlen(w)) & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            sk->index[i] = sk->index[j];
+            sk->slot_of[sk->index[i]] = i;
+            sk->index[j] = -1;
+            i = j;
+        }
+    }
+}
+
+// Додає кандидата в Space-Saving (count і err уже пораховано)
+static int ss_offer(WCSketch *sk, const char *word, size_t len, uint64_t h,
+                    uint64_t count, uint64_t err) {
+    size_t slot = ss_probe(sk, word, len, h);
+    if (sk->index[slot] >= 0) {
+        size_t pos = (size_t)sk->index[slot];
+        sk->heap[pos].count += count;
+        sk->heap[pos].err += err;
+        ss_sift_down(sk, pos);
+        return 0;
+    }
+    char *copy = malloc(len + 1);
+    if (!copy) return -1;
+    memcpy(copy, word, len);
+    copy[len] = '\0';
+    size_t pos;
+    if (sk->n < sk->k) {
+        pos = sk->n++;
+        sk->heap[pos].count = count;
+        sk->heap[pos].err = err;
+    } else {
+        // Витісняємо мінімальне слово: новому дістається його count
+        pos = 0;
+        uint64_t min = sk->heap[0].count;
+        ss_unindex(sk, sk->slot_of[0]);
+        free(sk->heap[0].word);
+        sk->heap[0].word = NULL;
+        slot = ss_probe(sk, word, len, h);
+        sk->heap[0].count = min + count;
+        sk->heap[0].err = min + err;
+    }
+    sk->heap[pos].word = copy;
+    sk->index[slot] = (int32_t)pos;
+    sk->slot_of[pos] = slot;
+    ss_sift_up(sk, pos);
+    ss_sift_down(sk, pos);
+    return 0;
+}
+
+int wc_sketch_add(WCSketch *sk, const char *word, size_t len, uint64_t count) {
+    uint64_t h = sketch_hash(word, len);
+    for (int row = 0; row < WC_CM_DEPTH; row++)
+        sk->cm[cm_cell(h, row)] += count;
+    sk->total += count;
+    return ss_offer(sk, word, len, h, count, 0);
+}
+
+typedef struct SketchCtx {
+    WCSketch *sk;
+    int failed;
+} SketchCtx;
+
+static void sketch_token(const char *word, size_t len, void *ctx) {
+    SketchCtx *sc = ctx;
+    if (wc_sketch_add(sc->sk, word, len, 1) != 0)
+        sc->failed = 1;
+}
+
+// Кожне слово йде в скетч одразу з токенізатора, без словника частини
+long wc_sketch_add_chunk(WCSketch *sk, const char *chunk, size_t len,
+                         const WCConfig *cfg) {
+    SketchCtx sc = { sk, 0 };
+    long words = each_chunk_token(chunk, len, cfg, sketch_token, &sc);
+    return sc.failed ? -1 : words;
+}
+
+uint64_t wc_sketch_estimate(const WCSketch *sk, const char *word, size_t len) {
+    uint64_t h = sketch_hash(word, len);
+    uint64_t est = sk->cm[cm_cell(h, 0)];
+    for (int row = 1; row < WC_CM_DEPTH; row++) {
+        uint64_t c = sk->cm[cm_cell(h, row)];
+        if (c < est) est = c;
+    }
+    return est;
+}
+
+uint64_t wc_sketch_total(const WCSketch *sk) {
+    return sk->total;
+}
+
+static int cmp_heavy_desc(const void *a, const void *b) {
+    const WCHeavy *x = a;
+    const WCHeavy *y = b;
+    if (x->count != y->count)
+        return x->count > y->count ? -1 : 1;
+    return strcmp(x->word, y->word);
+}
+
+size_t wc_sketch_heavy(const WCSketch *sk, WCHeavy *out, size_t max) {
+    WCHeavy *all = malloc((sk->n ? sk->n : 1) * sizeof(WCHeavy));
+    if (!all) return 0;
+    memcpy(all, sk->heap, sk->n * sizeof(WCHeavy));
+    qsort(all, sk->n, sizeof(WCHeavy), cmp_heavy_desc);
+    size_t n = sk->n < max ? sk->n : max;
+    memcpy(out, all, n * sizeof(WCHeavy));
+    free(all);
+    return n;
+}
+
+// Мінімум повного скетчу - межа для слів, яких у ньому немає
+static uint64_t ss_floor(const WCSketch *sk) {
+    return sk->n == sk->k ? sk->heap[0].count : 0;
+}
+
+static int32_t ss_find(const WCSketch *sk, const char *word) {
+    size_t len = strlen(word);
+    return sk->index[ss_probe(sk, word, len, sketch_hash(word, len))];
+}
+
+int wc_sketch_merge(WCSketch *dst, const WCSketch *src) {
+    if (dst->k != src->k) return -1;
+    for (size_t i = 0; i < (size_t)WC_CM_DEPTH * WC_CM_WIDTH; i++)
+        dst->cm[i] += src->cm[i];
+    dst->total += src->total;
+
+    // Обʼєднання кандидатів із межами обох скетчів
+    uint64_t floor_dst = ss_floor(dst), floor_src = ss_floor(src);
+    size_t n = 0;
+    WCHeavy *all = malloc((dst->n + src->n + 1) * sizeof(WCHeavy));
+    if (!all) return -1;
+    for (size_t i = 0; i < dst->n; i++) {
+        WCHeavy e = dst->heap[i];
+        int32_t j = ss_find(src, e.word);
+        e.count += j >= 0 ? src->heap[j].count : floor_src;
+        e.err += j >= 0 ? src->heap[j].err : floor_src;
+        all[n++] = e;
+    }
+    for (size_t i = 0; i < src->n; i++) {
+        if (ss_find(dst, src->heap[i].word) >= 0)
+            continue;
+        WCHeavy e = { strdup(src->heap[i].word), src->heap[i].count + floor_dst,
+                      src->heap[i].err + floor_dst };
+        if (!e.word) {
+            for (size_t j = dst->n; j < n; j++)
+                free(all[j].word);
+            free(all);
+            return -1;
+        }
+        all[n++] = e;
+    }
+
+    // Лишаємо K найбільших і перебудовуємо купу та індекс
+    qsort(all, n, sizeof(WCHeavy), cmp_heavy_desc);
+    for (size_t i = dst->k; i < n; i++)
+        free(all[i].word);
+    if (n > dst->k) n = dst->k;
+    memset(dst->index, 0xff, dst->n_index * sizeof(int32_t));
+    dst->n = 0;
+    for (size_t i = n; i-- > 0; ) {
+        size_t pos = dst->n++;
+        dst->heap[pos] = all[i];
+        size_t len = strlen(all[i].word);
+        size_t slot = ss_probe(dst, all[i].word, len, sketch_hash(all[i].word, len));
+        dst->index[slot] = (int32_t)pos;
+        dst->slot_of[pos] = slot;
+    }
+    free(all);
+    return 0;
+}
+
+/*
+ * Двійкова форма (little-endian):
+ *   "WCSK" u32 ширина u32 глибина u32 K u64 total u32 n
+ *   ширина * глибина лічильників u64
+ *   n разів: u16 довжина, байти слова, u64 count, u64 err
+ */
+static void sk_put(unsigned char **p, uint64_t v, int nbytes) {
+    for (int i = 0; i < nbytes; i++)
+        *(*p)++ = (unsigned char)(v >> (8 * i));
+}
+
+static uint64_t sk_get(const unsigned char *p, int nbytes) {
+    uint64_t v = 0;
+    for (int i = 0; i < nbytes; i++)
+        v |= (uint64_t)p[i] << (8 * i);
+    return v;
+}
+
+size_t wc_sketch_serialize(const WCSketch *sk, unsigned char *out, size_t outsize) {
+    size_t need = 4 + 4 + 4 + 4 + 8 + 4 + (size_t)WC_CM_DEPTH * WC_CM_WIDTH * 8;
+    for (size_t i = 0; i < sk->n; i++)
+        need += 2 + strlen(sk->heap[i].word) + 8 + 8;
+    if (!out || outsize < need)
+        return need;
+    unsigned char *p = out;
+    memcpy(p, SKETCH_MAGIC, 4);
+    p += 4;
+    sk_put(&p, WC_CM_WIDTH, 4);
+    sk_put(&p, WC_CM_DEPTH, 4);
+    sk_put(&p, sk->k, 4);
+    sk_put(&p, sk->total, 8);
+    sk_put(&p, sk->n, 4);
+    for (size_t i = 0; i < (size_t)WC_CM_DEPTH * WC_CM_WIDTH; i++)
+        sk_put(&p, sk->cm[i], 8);
+    // Кандидати - у порядку купи, тож розбір не переставляє їх
+    for (size_t i = 0; i < sk->n; i++) {
+        size_t len = strlen(sk->heap[i].word);
+        sk_put(&p, len, 2);
+        memcpy(p, sk->heap[i].word, len);
+        p += len;
+        sk_put(&p, sk->heap[i].count, 8);
+        sk_put(&p, sk->heap[i].err, 8);
+    }
+    return need;
+}
+
+WCSketch *wc_sketch_parse(const unsigned char *data, size_t len) {
+    size_t head = 4 + 4 + 4 + 4 + 8 + 4;
+    size_t cells = (size_t)WC_CM_DEPTH * WC_CM_WIDTH;
+    if (len < head + cells * 8 || memcmp(data, SKETCH_MAGIC, 4) != 0 ||
+        sk_get(data + 4, 4) != WC_CM_WIDTH || sk_get(data + 8, 4) != WC_CM_DEPTH)
+        return NULL;
+    size_t k = (size_t)sk_get(data + 12, 4);
+    size_t n = (size_t)sk_get(data + 24, 4);
+    if (n > k)
+        return NULL;
+    WCSketch *sk = wc_sketch_create(k);
+    if (!sk) return NULL;
+    sk->total = sk_get(data + 16, 8);
+    const unsigned char *p = data + head;
+    for (size_t i = 0; i < cells; i++, p += 8)
+        sk->cm[i] = sk_get(p, 8);
+    const unsigned char *end = data + len;
+    for (size_t i = 0; i < n; i++) {
+        if (end - p < 2) goto bad;
+        size_t wlen = (size_t)sk_get(p, 2);
+        p += 2;
+        if (wlen == 0 || (size_t)(end - p) < wlen + 16 || memchr(p, '\0', wlen))
+            goto bad;
+        uint64_t h = sketch_hash((const char *)p, wlen);
+        size_t slot = ss_probe(sk, (const char *)p, wlen, h);
+        if (sk->index[slot] >= 0) goto bad;     // Повтор слова
+        char *word = malloc(wlen + 1);
+        if (!word) goto bad;
+        memcpy(word, p, wlen);
+        word[wlen] = '\0';
+        p += wlen;
+        size_t pos = sk->n++;
+        sk->heap[pos].word = word;
+        sk->heap[pos].count = sk_get(p, 8);
+        sk->heap[pos].err = sk_get(p + 8, 8);
+        p += 16;
+        sk->index[slot] = (int32_t)pos;
+        sk->slot_of[pos] = slot;
+        ss_sift_up(sk, pos);
+    }
+    if (p != end) goto bad;
+    return sk;
+
+bad:
+    wc_sketch_free(sk);
+    return NULL;
+}
+
+/*************************************************************
+ *   HYPERLOGLOG
+ *
+ *  Хеш слова - той самий, що й у скетчі частот: старші
+ *  WC_HLL_BITS бітів вибирають регістр, а регістр зберігає
+ *  найбільший ранг (позиція першої одиниці в решті бітів).
+ *************************************************************/
+void wc_hll_add(WCHll *hll, const char *word, size_t len) {
+    uint64_t h = sketch_hash(word, len);
+    size_t idx = (size_t)(h >> (64 - WC_HLL_BITS));
+    uint64_t w = h << WC_HLL_BITS;
+    unsigned char rank = 1;
+    while (rank <= 64 - WC_HLL_BITS && !(w & (1ULL << 63))) {
+        rank++;
+        w <<= 1;
+    }
+    if (rank > hll->reg[idx])
+        hll->reg[idx] = rank;
+}
+
+static void hll_token(const char *word, size_t len, void *ctx) {
+    wc_hll_add(ctx, word, len);
+}
+
+// Повтори слова не змінюють регістрів, тож словник частини не потрібен
+long wc_hll_add_chunk(WCHll *hll, const char *chunk, size_t len, const WCConfig *cfg) {
+    return each_chunk_token(chunk, len, cfg, hll_token, hll);
+}
+
+void wc_hll_merge(WCHll *dst, const WCHll *src) {
+    for (size_t i = 0; i < WC_HLL_REGISTERS; i++) {
+        if (src->reg[i] > dst->reg[i])
+            dst->reg[i] = src->reg[i];
+    }
+}
+
+// Оцінка Flajolet et al. з лінійним підрахунком для малих множин
+double wc_hll_estimate(const WCHll *hll) {
+    const double m = WC_HLL_REGISTERS;
+    double sum = 0.0;
+    size_t zeros = 0;
+    for (size_t i = 0; i < WC_HLL_REGISTERS; i++) {
+        sum += ldexp(1.0, -hll->reg[i]);
+        zeros += hll->reg[i] == 0;
+    }
+    double alpha = 0.7213 / (1.0 + 1.079 / m);
+    double est = alpha * m * m / sum;
+    if (est <= 2.5 * m && zeros > 0)
+        est = m * log(m / (double)zeros);
+    return est;
+}
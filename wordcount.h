@@ -0,0 +1,335 @@
+/*************************************************************
+ *  wordcount.h - бібліотека підрахунку слів (libwordcount)
+ *
+ *  Спільне ядро воркера й дистриб'ютора, яке можна вбудувати
+ *  в інші програми:
+ *   - токенізатор (слово = послідовність літер, у нижньому
+ *     регістрі; ASCII або UTF-8);
+ *   - впорядкований хеш-словник (порядок вставки зберігається);
+ *   - ядра map ("word111...") та reduce ("word<n>...").
+ *
+ *  Усі функції повторно вхідні: жодних статичних буферів чи
+ *  глобального стану, тож їх можна викликати з кількох потоків
+ *  одночасно (кожен потік - зі своїм словником).
+ *************************************************************/
+#ifndef WORDCOUNT_H
+#define WORDCOUNT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define WC_HASH_SIZE 1024   // Початкова кількість бакетів словника (росте)
+#define WC_MAX_NGRAM 8      // Найбільше n для n-грам
+
+/*
+ * Вузол словника:
+ *  - word: слово (власна копія)
+ *  - hash: wc_hash64 слова із зерном словника
+ *  - count: частота
+ *  - next: наступний вузол у тому ж бакеті
+ *  - order_next: наступний вузол за порядком вставки
+ */
+typedef struct WCNode {
+    char *word;
+    size_t len;                 // Довжина word у байтах (без '\0')
+    uint64_t hash;
+    int count;
+    struct WCNode *next;
+    struct WCNode *order_next;
+} WCNode;
+
+typedef struct WCMap {
+    WCNode **buckets;           // n_buckets бакетів
+    size_t n_buckets;           // Степінь двійки; подвоюється, коли слів удвічі більше
+    WCNode *order_head;         // Початок ланцюжка порядку вставки
+    WCNode *order_tail;         // Кінець ланцюжка порядку вставки
+    size_t size;                // Кількість різних слів
+    uint64_t seed;              // Зерно wc_hash64 для цього словника
+} WCMap;
+
+/*************************************************************
+ *  Хеш
+ *************************************************************/
+// Швидкий хеш із зерном (по 16 байт за крок); ніколи не повертає 0
+uint64_t wc_hash64(const void *data, size_t len, uint64_t seed);
+
+/*************************************************************
+ *  Словник
+ *************************************************************/
+// Словник із випадковим зерном (захист від підібраних колізій)
+WCMap *wc_map_create(void);
+// Словник із заданим зерном: його хеші можна передати далі
+WCMap *wc_map_create_seeded(uint64_t seed);
+// Додає count до слова (створює вузол у кінці порядку вставки)
+int wc_map_add(WCMap *map, const char *word, int count);
+// Те саме для word[0..len) з уже порахованим wc_hash64(word, len, map->seed)
+int wc_map_add_hashed(WCMap *map, const char *word, size_t len, uint64_t hash, int count);
+WCNode *wc_map_find(const WCMap *map, const char *word);
+// Масив із map->size вузлів, відсортованих за словом (strcmp); звільняє викликач
+WCNode **wc_map_sorted(const WCMap *map);
+void wc_map_free(WCMap *map);
+
+/*************************************************************
+ *  Налаштування задачі
+ *
+ *  Однакові для всіх воркерів; дистриб'ютор передає їх командою
+ *  "cfg" у текстовому вигляді (wc_config_format), воркер
+ *  розбирає wc_config_parse. NULL замість WCConfig * означає
+ *  налаштування за замовчуванням.
+ *
+ *  Фільтри слів застосовуються під час підрахунку
+ *  (wc_count_text, wc_map_kernel): відкинуті слова не
+ *  потрапляють ні у словник, ні у відповідь.
+ *************************************************************/
+typedef struct WCFilter WCFilter;   // Стоп-слова й префікси (скомпільовані)
+
+typedef struct WCConfig {
+    int utf8;                   // 1: слова з літер Unicode у UTF-8, 0: лише ASCII
+    int sorted;                 // 1: результат map відсортовано за словом
+    int ngram;                  // n > 1: рахувати n-грами слів (0 або 1 - слова)
+    int decimal;                // 1: лічильники в "red" - десяткові числа
+    int min_len;                // Мінімальна довжина слова в символах (0 - будь-яка)
+    int max_len;                // Максимальна довжина слова в символах (0 - будь-яка)
+    int sketch;                 // K > 0: воркер веде скетч (топ-K) замість відповідей map
+    int distinct;               // 1: воркер лише оцінює к-сть різних слів (HyperLogLog)
+    WCFilter *filter;           // NULL - без стоп-слів і префіксів
+} WCConfig;
+
+#define WC_CONFIG_DEFAULT { 0, 0, 0, 0, 0, 0, 0, 0, NULL }
+
+/*
+ * Розбирає "utf8 sorted decimal distinct ngram=N min=N max=N
+ * sketch=K prefix=P stop=W ..." (слова
+ * через пробіл; prefix= і stop= можна повторювати). Слово
+ * проходить, якщо починається з одного з префіксів (коли вони
+ * задані) і не є стоп-словом. Префікси й стоп-слова мають бути
+ * вже в нормальній формі токенізатора. cfg має бути
+ * ініціалізовано (WC_CONFIG_DEFAULT); попередні налаштування
+ * звільняються лише в разі успіху. Повертає 0 або -1.
+ */
+int wc_config_parse(WCConfig *cfg, const char *spec);
+
+// Звільняє фільтри; cfg лишається придатним до wc_config_parse
+void wc_config_free(WCConfig *cfg);
+
+// Зворотне до wc_config_parse; "" для налаштувань за замовчуванням.
+// Як snprintf, повертає повну довжину (out може бути NULL при outsize 0)
+size_t wc_config_format(const WCConfig *cfg, char *out, size_t outsize);
+
+// 1, якщо слово (у нормальній формі) проходить фільтри cfg
+int wc_word_accepted(const WCConfig *cfg, const char *word, size_t len);
+
+/*************************************************************
+ *  Токенізатор
+ *
+ *  За замовчуванням слово - послідовність літер ASCII, решта
+ *  байтів - роздільники. З cfg->utf8 текст декодується як
+ *  UTF-8: словом є послідовність літер і знаків Unicode,
+ *  регістр згортається (проста згортка), невалідні байти -
+ *  роздільники. Блоки по 16 байт без символів поза ASCII
+ *  обробляються векторно (SSE2, якщо доступний).
+ *************************************************************/
+// Викликається для кожного слова word[0..len) - відрізка тексту
+// або буфера токенізатора, не завершеного '\0'
+typedef void (*wc_word_fn)(const char *word, size_t len, void *ctx);
+
+// Розбиває text[0..len) на слова; повертає кількість слів або -1
+long wc_tokenize(const char *text, size_t len, const WCConfig *cfg,
+                 wc_word_fn fn, void *ctx);
+
+// Додає всі слова text[0..len) до словника; повертає кількість слів або -1
+long wc_count_text(WCMap *map, const char *text, size_t len, const WCConfig *cfg);
+
+/*
+ * N-грами (cfg->ngram > 1): частина - "<L>:" + L байтів
+ * контексту (останні n-1 слів перед частиною) + текст. Рахуються
+ * лише n-грами, що закінчуються в тексті, тож кожна n-грама
+ * входу рахується рівно один раз. Ключ - слова через пробіл.
+ */
+// Рахує частину: звичайний текст або (з cfg->ngram > 1) з контекстом
+long wc_count_chunk(WCMap *map, const char *chunk, size_t len, const WCConfig *cfg);
+
+// Останні n-1 слів text[0..len) (після фільтрів) через пробіл -
+// контекст наступної частини; "", якщо він не вміщується в out
+size_t wc_ngram_context(const char *text, size_t len, const WCConfig *cfg,
+                        char *out, size_t outsize);
+
+// Записує слова text[0..len) у нормальній формі (як їх бачить
+// токенізатор), розділені одним пробілом; out - щонайменше
+// 2 * len + 1 байт. Повертає довжину результату або -1
+long wc_normalize(const char *text, size_t len, const WCConfig *cfg, char *out);
+
+/*************************************************************
+ *  Межі частин
+ *
+ *  Межа - будь-який байт ASCII, що не є літерою. В обох
+ *  режимах токенізатора він розділяє слова, тож текст можна
+ *  різати перед ним або після нього, не розриваючи слова.
+ *  Пошук векторний (SSE2, якщо доступний).
+ *************************************************************/
+// Найбільше c <= max, таке що text[c-1] або text[c] (c < len) - межа;
+// 0, якщо межі немає. Частина text[0..c) не закінчується серединою слова.
+size_t wc_chunk_cut(const char *text, size_t len, size_t max);
+
+// Кількість байтів-меж на початку text[0..len)
+size_t wc_skip_separators(const char *text, size_t len);
+
+/*************************************************************
+ *  Ядра map / reduce (формат повідомлень воркера)
+ *
+ *  Пишуть результат у out (не більше outsize - 1 байт і '\0')
+ *  і повертають його довжину. Якщо результат не вміщується,
+ *  він обрізається так само, як у відповіді воркера.
+ *************************************************************/
+// "текст" -> "word111word1..." (по '1' на кожне входження; слова за
+// порядком першої появи або, з cfg->sorted, за зростанням)
+size_t wc_map_kernel(const char *text, const WCConfig *cfg, char *out, size_t outsize);
+
+// "word111word1..." -> "word3word1..." (суми в десятковому вигляді;
+// з cfg->decimal вхід теж десятковий: "word2word1...").
+// Словом вважається будь-яка послідовність байтів, крім цифр.
+size_t wc_reduce_kernel(const char *payload, const WCConfig *cfg,
+                        char *out, size_t outsize);
+
+// Те саме для тексту без '\0' у кінці (напр. кадру ZeroMQ на місці)
+size_t wc_map_kernel_len(const char *text, size_t len, const WCConfig *cfg,
+                         char *out, size_t outsize);
+size_t wc_reduce_kernel_len(const char *payload, size_t len, const WCConfig *cfg,
+                            char *out, size_t outsize);
+
+/*
+ * Розбір "word111..." відрізками: довжина слова (байти до першої
+ * цифри ASCII) і серії '1' на початку text[0..len). Блоки по 16
+ * байт порівнюються векторно (SSE2, якщо доступний).
+ */
+size_t wc_word_span(const char *text, size_t len);
+size_t wc_ones_span(const char *text, size_t len);
+
+/*
+ * wc_word_clip: довжина слова, обрізаного до WC_WORD_MAX байтів.
+ * Різ зсувається назад до початку символу UTF-8, тож довге слово
+ * з --utf8 не закінчується половиною символу.
+ */
+#define WC_WORD_MAX 255
+size_t wc_word_clip(const char *word, size_t len);
+
+/*************************************************************
+ *  Часті слова
+ *
+ *  WC_COMMON_WORDS найчастіших англійських слів (за текстами з
+ *  test_files/) вкомпільовано як досконалий хеш (common_words.h,
+ *  генерує tools/gen_common_words.py). Номер - ранг слова за
+ *  частотою; пошук без проб і виділення памʼяті.
+ *************************************************************/
+#define WC_COMMON_WORDS 1024
+
+// Номер слова word[0..len) (у нормальній формі) або -1
+int wc_common_word(const char *word, size_t len);
+// Слово з номером id (0 <= id < WC_COMMON_WORDS), завершене '\0'
+const char *wc_common_word_text(int id);
+
+/*************************************************************
+ *  Словник номерів слів (інтернування)
+ *
+ *  Живе між запитами (напр. увесь час роботи воркера): слово
+ *  отримує стабільний номер, а запит рахує входження в щільному
+ *  масиві лічильників за номером - часті слова не вставляються
+ *  й не копіюються в новий словник на кожен запит. Номери
+ *  0..WC_COMMON_WORDS-1 - часті слова (wc_common_word), решта
+ *  шукається в таблиці. Словник, у якому max_words слів або
+ *  більше, очищається перед наступним запитом. Один словник -
+ *  для одного потоку.
+ *************************************************************/
+#define WC_INTERN_MAX_WORDS (1 << 20)
+
+typedef struct WCIntern WCIntern;
+
+WCIntern *wc_intern_create(size_t max_words);
+void wc_intern_free(WCIntern *in);
+// Забуває всі слова (номери знову починаються з 0)
+void wc_intern_clear(WCIntern *in);
+// Номер слова word[0..len) (нове слово додається) або -1 (немає памʼяті)
+long wc_intern_id(WCIntern *in, const char *word, size_t len);
+
+// Як wc_map_kernel_len / wc_reduce_kernel_len, але з лічильниками за
+// номерами in; результат той самий. N-грами та in == NULL - через WCMap
+size_t wc_map_kernel_intern(WCIntern *in, const char *text, size_t len,
+                            const WCConfig *cfg, char *out, size_t outsize);
+size_t wc_reduce_kernel_intern(WCIntern *in, const char *payload, size_t len,
+                               const WCConfig *cfg, char *out, size_t outsize);
+
+/*************************************************************
+ *  Скетч частот (наближені важковаговики)
+ *
+ *  Count-Min (WC_CM_DEPTH рядків по WC_CM_WIDTH лічильників) і
+ *  Space-Saving на K слів. Памʼять не залежить від словника.
+ *  Для кожного слова Count-Min дає оцінку зверху, що перевищує
+ *  точну не більше ніж на e / WC_CM_WIDTH * total з імовірністю
+ *  1 - e^-WC_CM_DEPTH; Space-Saving тримає кандидатів у
+ *  важковаговики з межами count - err <= точна <= count. Скетчі
+ *  з однаковим K зливаються без втрати цих гарантій.
+ *************************************************************/
+#define WC_CM_WIDTH 4096        // Лічильників у рядку Count-Min (степінь двійки)
+#define WC_CM_DEPTH 4           // Рядків Count-Min
+#define WC_SKETCH_MAX_K 65536   // Найбільше K для Space-Saving
+
+typedef struct WCSketch WCSketch;
+
+typedef struct WCHeavy {
+    char *word;                 // Належить скетчу
+    uint64_t count;             // Оцінка зверху
+    uint64_t err;               // count - err - оцінка знизу
+} WCHeavy;
+
+WCSketch *wc_sketch_create(size_t k);
+void wc_sketch_free(WCSketch *sk);
+
+// Додає count входжень слова; повертає 0 або -1 (немає памʼяті)
+int wc_sketch_add(WCSketch *sk, const char *word, size_t len, uint64_t count);
+
+// Додає до скетчу слова частини (те, що рахує wc_count_chunk)
+long wc_sketch_add_chunk(WCSketch *sk, const char *chunk, size_t len,
+                         const WCConfig *cfg);
+
+// Оцінка Count-Min (зверху) і сума всіх лічильників
+uint64_t wc_sketch_estimate(const WCSketch *sk, const char *word, size_t len);
+uint64_t wc_sketch_total(const WCSketch *sk);
+
+// Записує до max кандидатів за спаданням count; повертає їх к-сть
+size_t wc_sketch_heavy(const WCSketch *sk, WCHeavy *out, size_t max);
+
+// Додає src до dst (однакове K); повертає 0 або -1
+int wc_sketch_merge(WCSketch *dst, const WCSketch *src);
+
+// Двійкова форма для передачі. Як snprintf, повертає повну
+// довжину; out записується, лише якщо вона вміщується в outsize
+size_t wc_sketch_serialize(const WCSketch *sk, unsigned char *out, size_t outsize);
+
+// Зворотне до wc_sketch_serialize; NULL для пошкоджених даних
+WCSketch *wc_sketch_parse(const unsigned char *data, size_t len);
+
+/*************************************************************
+ *  HyperLogLog (оцінка кількості різних слів)
+ *
+ *  2^WC_HLL_BITS однобайтових регістрів; стандартна похибка
+ *  близько 1.04 / sqrt(2^WC_HLL_BITS) (0.8%). Регістри - і є
+ *  двійкова форма для передачі; злиття - поелементний максимум,
+ *  тож повторне додавання тих самих слів нічого не змінює.
+ *************************************************************/
+#define WC_HLL_BITS 14
+#define WC_HLL_REGISTERS (1 << WC_HLL_BITS)
+
+typedef struct WCHll {
+    unsigned char reg[WC_HLL_REGISTERS];
+} WCHll;
+
+// Обнулені регістри (memset) - порожня множина
+void wc_hll_add(WCHll *hll, const char *word, size_t len);
+
+// Додає до регістрів слова частини (те, що рахує wc_count_chunk)
+long wc_hll_add_chunk(WCHll *hll, const char *chunk, size_t len, const WCConfig *cfg);
+
+void wc_hll_merge(WCHll *dst, const WCHll *src);
+double wc_hll_estimate(const WCHll *hll);
+
+#endif /* WORDCOUNT_H */
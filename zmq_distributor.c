@@ -1,5 +1,4 @@
 /*************************************************************
-<<<<<<< HEAD
  *  distributor_fixed.c
  *
  *  This version fixes the "Too many open files" problem by
@@ -8,17 +7,6 @@
  *  thread/socket per chunk).
  *
  *  Comments are in Ukrainian, as requested.
-=======
- *  zmq_distributor.c
- *  Логика Дистрибьютора:
- *   - чтение файла
- *   - разбиение на строки
- *   - отправка "map..." воркерам
- *   - сбор ответов, парсинг
- *   - отправка "red..." одному воркеру
- *   - финальная сортировка и вывод
- *   - "rip" всем воркерам
->>>>>>> dc6bdc5 (Test handout)
  *************************************************************/
 
 #include <stdio.h>
@@ -28,16 +16,207 @@
 #include <pthread.h>
 #include <zmq.h>
 #include <unistd.h>
+#include <getopt.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <math.h>
+
+#include "wordcount.h"
+#include "affinity.h"
 
-<<<<<<< HEAD
 #define MAX_MSG_SIZE 1500
 #define HASH_SIZE 1024
+#define CHUNK_SIZE 1496        // "map" + payload + '\0' вміщується в 1500
+#define CHUNK_HEADROOM 3       // Перед кожною частиною в памʼяті - "map"
+#define READ_BUF_SIZE 65536    // Розмір блоку читання вхідних даних
+#define CHUNK_SEGMENT (1 << 20) // Сегмент входу, що ріжеться незалежно
+#define NGRAM_WINDOW 1024       // Де шукати контекст n-грам перед частиною
+#define NGRAM_CONTEXT_MAX 512   // Найдовший контекст n-грам у частині
+#define DEFAULT_CKPT_INTERVAL 30  // Секунд між контрольними точками
+
+/*************************************************************
+ *  ІНТЕРНУВАННЯ СЛІВ
+ *
+ *  Кожне слово зберігається рівно один раз в арені - суцільній
+ *  області, куди слова (з '\0') лише дописуються. Проміжна й
+ *  фінальна мапи посилаються на слова 32-бітними зсувами, тож
+ *  рівність слів - це рівність зсувів, і слово хешується лише
+ *  раз (wc_hash64 із випадковим зерном арени, хеш зберігається в
+ *  комірці таблиці). Арена резервує адресний
+ *  простір одразу (mmap без резервування памʼяті), тож слова
+ *  ніколи не переміщуються, і читати їх можна без блокування.
+ *************************************************************/
+#define ARENA_MAX ((size_t)UINT32_MAX)      // Зсуви - 32-бітні
+#define ARENA_MIN ((size_t)64 << 20)        // Найменше резервування
+
+typedef struct InternSlot {
+    uint32_t word;              // Зсув слова + 1 (0 - порожня комірка)
+    uint32_t hash;
+} InternSlot;
+
+typedef struct WordArena {
+    char *data;
+    size_t len;                 // Зайнято байтів
+    size_t reserved;            // Зарезервовано байтів
+    InternSlot *slots;          // Відкрита адресація, заповнена не більше ніж наполовину
+    size_t n_slots;             // Степінь двійки
+    size_t count;               // Різних слів
+    uint64_t seed;              // Зерно wc_hash64 (випадкове)
+    pthread_mutex_t lock;
+} WordArena;
+
+static WordArena g_words = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+#define WORD(off) (g_words.data + (off))
+
+static int arena_init(WordArena *a) {
+    // Випадкове зерно: вхідний текст не може підібрати колізії
+    FILE *rnd = fopen("/dev/urandom", "rb");
+    if (!rnd || fread(&a->seed, sizeof(a->seed), 1, rnd) != 1)
+        a->seed = (uint64_t)time(NULL) ^ ((uint64_t)getpid() << 32);
+    if (rnd)
+        fclose(rnd);
+    // Найбільше резервування, яке дозволяє система
+    for (size_t size = ARENA_MAX; size >= ARENA_MIN; size /= 2) {
+        void *p = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (p != MAP_FAILED) {
+            a->data = p;
+            a->reserved = size;
+            break;
+        }
+    }
+    a->n_slots = HASH_SIZE;
+    a->slots = calloc(a->n_slots, sizeof(InternSlot));
+    if (!a->data || !a->slots) {
+        perror("arena_init");
+        return -1;
+    }
+    return 0;
+}
+
+static void arena_free(WordArena *a) {
+    if (a->data)
+        munmap(a->data, a->reserved);
+    free(a->slots);
+    a->data = NULL;
+    a->slots = NULL;
+}
+
+static void intern_grow(WordArena *a) {
+    size_t n = a->n_slots * 2;
+    InternSlot *slots = calloc(n, sizeof(InternSlot));
+    if (!slots) {
+        // Без росту таблиця заповниться, і пошук вільної комірки не скінчиться
+        fprintf(stderr, "Word table cannot grow to %zu slots\n", n);
+        exit(1);
+    }
+    for (size_t i = 0; i < a->n_slots; i++) {
+        if (!a->slots[i].word) continue;
+        size_t j = a->slots[i].hash & (n - 1);
+        while (slots[j].word)
+            j = (j + 1) & (n - 1);
+        slots[j] = a->slots[i];
+    }
+    free(a->slots);
+    a->slots = slots;
+    a->n_slots = n;
+}
+
+// Дописує word[0..len) і '\0' в кінець арени (викликати під a->lock)
+static uint32_t arena_store(WordArena *a, const char *word, size_t len) {
+    if (a->len + len + 1 >= a->reserved) {
+        fprintf(stderr, "Word arena is full (%zu bytes)\n", a->reserved);
+        exit(1);
+    }
+    uint32_t off = (uint32_t)a->len;
+    memcpy(a->data + off, word, len);
+    a->data[off + len] = '\0';
+    a->len += len + 1;
+    return off;
+}
+
+/*
+ * arena_append: зсув нової копії word в арені, без пошуку в
+ * таблиці. Для слів, які вже гарантовано різні (злиті серії
+ * --sorted-runs), хешування й проби зайві.
+ */
+static uint32_t arena_append(const char *word) {
+    pthread_mutex_lock(&g_words.lock);
+    uint32_t off = arena_store(&g_words, word, strlen(word));
+    pthread_mutex_unlock(&g_words.lock);
+    return off;
+}
+
+/*
+ * intern_hashed: зсув слова word[0..len) в арені (дописує його,
+ * якщо слово нове); hash - wc_hash64(word, len, g_words.seed).
+ */
+static uint32_t intern_hashed(const char *word, size_t len, uint64_t hash) {
+    uint32_t h = (uint32_t)(hash ^ (hash >> 32));
+    WordArena *a = &g_words;
+    pthread_mutex_lock(&a->lock);
+    size_t mask = a->n_slots - 1;
+    size_t i = h & mask;
+    for (; a->slots[i].word; i = (i + 1) & mask) {
+        uint32_t off = a->slots[i].word - 1;
+        if (a->slots[i].hash == h && memcmp(a->data + off, word, len) == 0 &&
+            a->data[off + len] == '\0') {
+            pthread_mutex_unlock(&a->lock);
+            return off;
+        }
+    }
+    uint32_t off = arena_store(a, word, len);
+    a->slots[i].word = off + 1;
+    a->slots[i].hash = h;
+    if (++a->count * 2 > a->n_slots)
+        intern_grow(a);
+    pthread_mutex_unlock(&a->lock);
+    return off;
+}
+
+// Зсуви частих слів (wc_common_word) - в арені від самого початку
+static uint32_t g_common_off[WC_COMMON_WORDS];
+
+static void intern_common(void) {
+    for (int id = 0; id < WC_COMMON_WORDS; id++) {
+        const char *word = wc_common_word_text(id);
+        size_t len = strlen(word);
+        g_common_off[id] = intern_hashed(word, len, wc_hash64(word, len, g_words.seed));
+    }
+}
+
+// Те саме для відрізка word[0..len) (без '\0' у кінці)
+static uint32_t intern_len(const char *word, size_t len) {
+    // Часте слово: зсув без хешування, мʼютекса й проб
+    int common = wc_common_word(word, len);
+    if (common >= 0)
+        return g_common_off[common];
+    return intern_hashed(word, len, wc_hash64(word, len, g_words.seed));
+}
+
+static uint32_t intern(const char *word) {
+    return intern_len(word, strlen(word));
+}
+
+// Хеш зсуву для бакетів (зсуви не випадкові в молодших бітах)
+static size_t word_slot(uint32_t word, size_t n_buckets) {
+    uint64_t h = (uint64_t)word * 0x9E3779B97F4A7C15ULL;
+    return (size_t)((h ^ (h >> 32)) & (n_buckets - 1));
+}
 
 /*************************************************************
  *  СТРУКТУРИ ТА ФУНКЦІЇ ДЛЯ OrderedMap (проміжна мапа)
  *************************************************************/
 typedef struct OMNode {
-    char *word;
+    uint32_t word;              // Зсув в арені
     int count;
     struct OMNode *bucket_next;
     struct OMNode *order_next;
@@ -45,40 +224,50 @@ typedef struct OMNode {
 
 typedef struct OrderedMap {
     OMNode **buckets;
+    size_t n_buckets;           // Степінь двійки, росте разом зі словником
+    size_t size;
     OMNode *order_head;
     OMNode *order_tail;
 } OrderedMap;
 
-// djb2 hash
-static unsigned int om_hash(const char *str) {
-    unsigned long hash = 5381;
-    int c;
-    while ((c = *str++))
-        hash = ((hash << 5) + hash) + c;
-    return (unsigned int)(hash % HASH_SIZE);
-}
-
 static OrderedMap *om_create(void) {
     OrderedMap *om = malloc(sizeof(OrderedMap));
     if (!om) return NULL;
     om->buckets = calloc(HASH_SIZE, sizeof(OMNode *));
+    om->n_buckets = HASH_SIZE;
+    om->size = 0;
     om->order_head = NULL;
     om->order_tail = NULL;
     return om;
 }
 
-static void om_update(OrderedMap *om, const char *word, int count) {
-    unsigned int idx = om_hash(word);
+// Подвоює кількість бакетів, коли слів стає вдвічі більше
+static void om_grow(OrderedMap *om) {
+    size_t n = om->n_buckets * 2;
+    OMNode **buckets = calloc(n, sizeof(OMNode *));
+    if (!buckets) return;
+    for (OMNode *node = om->order_head; node; node = node->order_next) {
+        size_t idx = word_slot(node->word, n);
+        node->bucket_next = buckets[idx];
+        buckets[idx] = node;
+    }
+    free(om->buckets);
+    om->buckets = buckets;
+    om->n_buckets = n;
+}
+
+static void om_update(OrderedMap *om, uint32_t word, int count) {
+    size_t idx = word_slot(word, om->n_buckets);
     OMNode *node = om->buckets[idx];
     while (node) {
-        if (strcmp(node->word, word) == 0) {
+        if (node->word == word) {
             node->count += count;
             return;
         }
         node = node->bucket_next;
     }
     OMNode *new_node = malloc(sizeof(OMNode));
-    new_node->word = strdup(word);
+    new_node->word = word;
     new_node->count = count;
     new_node->bucket_next = om->buckets[idx];
     om->buckets[idx] = new_node;
@@ -90,13 +279,15 @@ static void om_update(OrderedMap *om, const char *word, int count) {
         om->order_head = new_node;
         om->order_tail = new_node;
     }
+    if (++om->size > 2 * om->n_buckets)
+        om_grow(om);
 }
 
-static void om_remove(OrderedMap *om, const char *word) {
-    unsigned int idx = om_hash(word);
+static void om_remove(OrderedMap *om, uint32_t word) {
+    size_t idx = word_slot(word, om->n_buckets);
     OMNode **pp = &om->buckets[idx];
     while (*pp) {
-        if (strcmp((*pp)->word, word) == 0) {
+        if ((*pp)->word == word) {
             OMNode *to_delete = *pp;
             *pp = to_delete->bucket_next;
             // Видаляємо з ланцюжка order
@@ -114,8 +305,8 @@ static void om_remove(OrderedMap *om, const char *word) {
                         om->order_tail = prev;
                 }
             }
-            free(to_delete->word);
             free(to_delete);
+            om->size--;
             return;
         }
         pp = &((*pp)->bucket_next);
@@ -128,7 +319,6 @@ static void om_free(OrderedMap *om) {
     while (node) {
         OMNode *tmp = node;
         node = node->order_next;
-        free(tmp->word);
         free(tmp);
     }
     free(om->buckets);
@@ -137,62 +327,151 @@ static void om_free(OrderedMap *om) {
 
 /*************************************************************
  *  СТРУКТУРИ ТА ФУНКЦІЇ ДЛЯ фінального HashMap
+ *
+ *  Пари (зсув слова, частота) лежать суцільним масивом у
+ *  порядку вставки; індекс - відкрита адресація за зсувом.
+ *  Фінальний обхід іде масивом послідовно.
  *************************************************************/
 typedef struct FPNode {
-    char *word;
+    uint32_t word;              // Зсув в арені
     int count;
-    struct FPNode *next;
 } FPNode;
 
 typedef struct HashMap {
-    FPNode **buckets;
+    FPNode *items;
+    size_t size;
+    size_t capacity;
+    uint32_t *slots;            // Індекс у items + 1 (0 - порожньо)
+    size_t n_slots;             // Степінь двійки, щонайменше 2 * size
 } HashMap;
 
 static HashMap *hm_create(void) {
-    HashMap *map = malloc(sizeof(HashMap));
+    HashMap *map = calloc(1, sizeof(HashMap));
     if (!map) return NULL;
-    map->buckets = calloc(HASH_SIZE, sizeof(FPNode *));
+    map->slots = calloc(HASH_SIZE, sizeof(uint32_t));
+    map->n_slots = HASH_SIZE;
     return map;
 }
 
-static unsigned int final_hash(const char *word) {
-    unsigned long hash = 5381;
-    const unsigned char *ptr = (const unsigned char *)word;
-    while (*ptr)
-        hash = ((hash << 5) + hash) + *ptr++;
-    return (unsigned int)(hash % HASH_SIZE);
+static void hm_grow(HashMap *map) {
+    size_t n = map->n_slots * 2;
+    uint32_t *slots = calloc(n, sizeof(uint32_t));
+    if (!slots) return;
+    for (size_t i = 0; i < map->size; i++) {
+        size_t j = word_slot(map->items[i].word, n);
+        while (slots[j])
+            j = (j + 1) & (n - 1);
+        slots[j] = (uint32_t)i + 1;
+    }
+    free(map->slots);
+    map->slots = slots;
+    map->n_slots = n;
 }
 
-static void hm_update(HashMap *map, const char *word, int count) {
-    unsigned int idx = final_hash(word);
-    FPNode *node = map->buckets[idx];
-    while (node) {
-        if (strcmp(node->word, word) == 0) {
+static void hm_update(HashMap *map, uint32_t word, int count) {
+    size_t mask = map->n_slots - 1;
+    size_t i = word_slot(word, map->n_slots);
+    for (; map->slots[i]; i = (i + 1) & mask) {
+        FPNode *node = &map->items[map->slots[i] - 1];
+        if (node->word == word) {
             node->count += count;
             return;
         }
-        node = node->next;
     }
-    FPNode *newnode = malloc(sizeof(FPNode));
-    newnode->word = strdup(word);
-    newnode->count = count;
-    newnode->next = map->buckets[idx];
-    map->buckets[idx] = newnode;
+    if (map->size == map->capacity) {
+        size_t cap = map->capacity ? map->capacity * 2 : HASH_SIZE;
+        FPNode *tmp = realloc(map->items, cap * sizeof(FPNode));
+        if (!tmp) {
+            fprintf(stderr, "Not enough memory\n");
+            exit(1);
+        }
+        map->items = tmp;
+        map->capacity = cap;
+    }
+    map->items[map->size] = (FPNode){ word, count };
+    map->slots[i] = (uint32_t)++map->size;
+    if (map->size * 2 > map->n_slots)
+        hm_grow(map);
 }
 
 static void hm_free(HashMap *map) {
     if (!map) return;
-    for (int i = 0; i < HASH_SIZE; i++) {
-        FPNode *node = map->buckets[i];
-        while (node) {
-            FPNode *tmp = node;
-            node = node->next;
-            free(tmp->word);
-            free(tmp);
+    free(map->items);
+    free(map->slots);
+    free(map);
+}
+
+/*************************************************************
+ *  ChunkArray: масив частин (chunks), що наповнюється під час
+ *  читання входу. Потоки map чекають на нові частини через
+ *  умовну змінну, тому розсилка починається ще до того, як
+ *  увесь вхід прочитано (потрібно для stdin / pipe).
+ *************************************************************/
+typedef struct ChunkArray {
+    char **items;               // Усі згенеровані частини
+    int count;                  // Кількість уже доданих частин
+    int capacity;               // Розмір масиву items
+    int done;                   // 1, коли вхід вичерпано
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} ChunkArray;
+
+static void chunks_init(ChunkArray *ca) {
+    ca->items = NULL;
+    ca->count = 0;
+    ca->capacity = 0;
+    ca->done = 0;
+    pthread_mutex_init(&ca->lock, NULL);
+    pthread_cond_init(&ca->cond, NULL);
+}
+
+static int chunks_push(ChunkArray *ca, char *chunk) {
+    pthread_mutex_lock(&ca->lock);
+    if (ca->count == ca->capacity) {
+        int new_cap = ca->capacity ? ca->capacity * 2 : 1024;
+        char **tmp = realloc(ca->items, new_cap * sizeof(char *));
+        if (!tmp) {
+            pthread_mutex_unlock(&ca->lock);
+            return -1;
         }
+        ca->items = tmp;
+        ca->capacity = new_cap;
     }
-    free(map->buckets);
-    free(map);
+    ca->items[ca->count++] = chunk;
+    pthread_cond_broadcast(&ca->cond);
+    pthread_mutex_unlock(&ca->lock);
+    return 0;
+}
+
+// Позначає кінець входу й будить усі потоки, що чекають
+static void chunks_finish(ChunkArray *ca) {
+    pthread_mutex_lock(&ca->lock);
+    ca->done = 1;
+    pthread_cond_broadcast(&ca->cond);
+    pthread_mutex_unlock(&ca->lock);
+}
+
+// Чекає на частину з індексом idx; NULL, якщо вхід закінчився раніше
+static char *chunks_wait(ChunkArray *ca, int idx) {
+    pthread_mutex_lock(&ca->lock);
+    while (idx >= ca->count && !ca->done)
+        pthread_cond_wait(&ca->cond, &ca->lock);
+    char *chunk = (idx < ca->count) ? ca->items[idx] : NULL;
+    pthread_mutex_unlock(&ca->lock);
+    return chunk;
+}
+
+// Частина виділяється разом із префіксом "map" перед нею
+static void chunk_release(char *chunk) {
+    free(chunk - CHUNK_HEADROOM);
+}
+
+static void chunks_free(ChunkArray *ca) {
+    for (int i = 0; i < ca->count; i++)
+        chunk_release(ca->items[i]);
+    free(ca->items);
+    pthread_mutex_destroy(&ca->lock);
+    pthread_cond_destroy(&ca->cond);
 }
 
 /*************************************************************
@@ -206,726 +485,3118 @@ static pthread_mutex_t global_hash_lock = PTHREAD_MUTEX_INITIALIZER;
 
 static void *g_zmq_context = NULL;
 
-/*************************************************************
- *  Структура для даних потоку (один потік на кожного воркера)
- *************************************************************/
-typedef struct WorkerThreadData {
-    int worker_index;           // Індекс воркера (0..n-1)
-    char *endpoint;             // "tcp://localhost:XXXX"
-    // Нижче — інформація про всі chunks:
-    char **chunk_array;         // Усі згенеровані частини
-    int total_chunks;           // Загальна кількість частин
-    int n_workers;              // Кількість воркерів
-} WorkerThreadData;
-
-/*************************************************************
- *  aggregate_map_reply: розбирає "word111word111..." та
- *  оновлює global_omap під мʼютексом
- *************************************************************/
-static void aggregate_map_reply(const char *reply) {
-    const char *p = reply;
-    while (*p != '\0') {
-        char word_buf[256];
-        int wpos = 0;
-        while (*p && isalpha((unsigned char)*p)) {
-            if (wpos < 255) {
-                word_buf[wpos++] = *p;
-            }
-            p++;
-=======
-#define MSG_SIZE 1500
-
-// -------------------------------
-// Структуры
-// -------------------------------
-typedef struct Pair {
-    char *word;
-    int count;
-    struct Pair *next;
-} Pair;
-
-static Pair *g_map_results = NULL;
-static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
-
-typedef struct WorkerInfo {
-    int index;
-    char *endpoint;
-    char *chunk;
-} WorkerInfo;
-
-void *g_zmq_context = NULL;
-
-typedef struct FinalPair {
-    char *word;
-    int count;
-    struct FinalPair *next;
-} FinalPair;
-
-static FinalPair *g_final_list = NULL;
-static pthread_mutex_t g_final_lock = PTHREAD_MUTEX_INITIALIZER;
-
-// -------------------------------
-// Вспомогательные функции
-// -------------------------------
-
-// Добавляет (word, count) в g_map_results в конец списка
-static void add_to_global_map(const char *word, int c) {
-    pthread_mutex_lock(&g_lock);
-
-    Pair *p = g_map_results;
+// CPU для потоків (--cpu-list / --numa-node); порожній - без закріплення
+static CpuList g_affinity = { NULL, 0 };
+
+// Налаштування задачі (--utf8 ...), які воркери отримують командою
+// "cfg", і їхній відбиток для кешу та контрольних точок (0 - типові)
+static WCConfig g_job_cfg = WC_CONFIG_DEFAULT;
+static char *g_job_spec = NULL;
+static uint64_t g_job_tag = 0;
+
+// Номер задачі на дроті: "@" і JOB_ID_LEN шістнадцяткових цифр, ""
+// для типової. Воркер тримає налаштування лише однієї задачі й на
+// запит з іншим номером відповідає UNKNOWN_JOB (див. zmq_worker.c)
+#define JOB_ID_LEN 16
+#define UNKNOWN_JOB "cfg?"
+static char g_job_id[JOB_ID_LEN + 2] = "";
+
+// Воркер втратив накопичений скетч чи регістри (--heavy, --distinct)
+static volatile int g_state_lost = 0;
+
+// --normalize: частини містять лише слова через пробіл
+static int g_normalize = 0;
+
+/*
+ * Множина завершених частин (бітова мапа за індексом частини).
+ * Оновлюється разом із global_omap під global_omap_lock, тому
+ * контрольна точка завжди бачить узгоджений стан.
+ */
+static unsigned char *g_done_bits = NULL;
+static int g_done_nbits = 0;
+
+static int chunk_done_locked(int idx) {
+    if (idx >= g_done_nbits) return 0;
+    return (g_done_bits[idx / 8] >> (idx % 8)) & 1;
+}
 
-    while (p) {
-        if (strcmp(p->word, word) == 0) {
-            p->count += c;
-            pthread_mutex_unlock(&g_lock);
-            return;
-        }
-        p = p->next;
+static void chunk_mark_done_locked(int idx) {
+    if (idx >= g_done_nbits) {
+        int nbits = g_done_nbits ? g_done_nbits : 8192;
+        while (nbits <= idx) nbits *= 2;
+        unsigned char *tmp = realloc(g_done_bits, nbits / 8);
+        if (!tmp) return;
+        memset(tmp + g_done_nbits / 8, 0, (nbits - g_done_nbits) / 8);
+        g_done_bits = tmp;
+        g_done_nbits = nbits;
     }
+    g_done_bits[idx / 8] |= (unsigned char)(1u << (idx % 8));
+}
 
-    Pair *newp = malloc(sizeof(*newp));
-    if (!newp) {
-        pthread_mutex_unlock(&g_lock);
-        return;
-    }
+static int chunk_is_done(int idx) {
+    pthread_mutex_lock(&global_omap_lock);
+    int done = chunk_done_locked(idx);
+    pthread_mutex_unlock(&global_omap_lock);
+    return done;
+}
 
-    newp->word = strdup(word);
-    if (!newp->word) {
-        free(newp);
-        pthread_mutex_unlock(&g_lock);
-        return;
+/*************************************************************
+ *  НАРІЗАННЯ ВХОДУ НА ЧАСТИНИ
+ *
+ *  Вхід ділиться на сегменти по CHUNK_SEGMENT байт; межа
+ *  сегмента - остання межа слова не далі за k * CHUNK_SEGMENT
+ *  (wc_chunk_cut), тож сегменти ріжуться незалежно, а частини
+ *  не залежать від способу читання (mmap чи потік) і кількості
+ *  потоків. У сегменті частина - до CHUNK_SIZE байт і
+ *  закінчується на межі слова (будь-якому байті ASCII, що не
+ *  літера); межі між частинами пропускаються.
+ *************************************************************/
+
+/*
+ * ngram_header: заголовок частини в режимі n-грам - "<L>:" і
+ * останні n-1 слів перед text[pos] (див. wc_count_chunk), не
+ * довші за ctx_max байт. Контекст шукається не далі ніж за
+ * NGRAM_WINDOW байтів; hist байтів перед text належать
+ * попередньому сегменту. Повертає довжину заголовка, L - у *wlen.
+ */
+static size_t ngram_header(const char *text, size_t pos, size_t hist, size_t ctx_max,
+                           char *out, size_t outsize, size_t *wlen) {
+    size_t back = pos + hist;
+    const char *end = text + pos;
+    const char *from = end - (back > NGRAM_WINDOW ? NGRAM_WINDOW : back);
+    if (back > NGRAM_WINDOW) {
+        // Вікно могло початися посеред слова: пропускаємо його
+        while (from < end && ((unsigned char)*from >= 0x80 || isalpha((unsigned char)*from)))
+            from++;
     }
+    char words[NGRAM_CONTEXT_MAX];
+    *wlen = wc_ngram_context(from, (size_t)(end - from), &g_job_cfg, words, ctx_max);
+    int n = snprintf(out, outsize, "%zu:%s", *wlen, words);
+    return (n > 0 && (size_t)n < outsize) ? (size_t)n : 0;
+}
 
-    newp->count = c;
-    newp->next = NULL;
+/*
+ * ngram_text_limit: скільки байтів тексту можна дати частині з
+ * контекстом wlen байт, щоб відповідь map вмістилася в кадр.
+ * Слово входить щонайбільше в n n-грам і щоразу займає свою
+ * довжину + 1 байт (пробіл або '1'); слова контексту - в n-1.
+ */
+static size_t ngram_text_limit(size_t wlen) {
+    size_t n = (size_t)g_job_cfg.ngram;
+    size_t budget = MAX_MSG_SIZE - 1;
+    size_t ctx = (n - 1) * (wlen + 1);
+    if (ctx + n >= budget)
+        return 1;
+    return (budget - ctx) / n - 1;
+}
 
-    if (g_map_results == NULL) {
-        g_map_results = newp;
-    } else {
-        Pair *last = g_map_results;
-        while (last->next) {
-            last = last->next;
+/*
+ * chunk_span: ріже text[0..len) на частини й додає їх у ca. У
+ * режимі n-грам перед кожною частиною йде заголовок контексту
+ * (ngram_header), а текст частини коротший, щоб відповідь із
+ * n-грамами вмістилася в MAX_MSG_SIZE (ngram_text_limit).
+ * Перед кожною частиною лишається CHUNK_HEADROOM байт із "map",
+ * тож повідомлення "map" + частина надсилається з неї ж.
+ * Повертає 0 або -1 (немає памʼяті).
+ */
+static int chunk_span(const char *text, size_t len, ChunkArray *ca, size_t hist) {
+    // Контекст займає не більше половини відповіді
+    size_t ctx_max = NGRAM_CONTEXT_MAX;
+    if (g_job_cfg.ngram > 1 &&
+        ctx_max > (MAX_MSG_SIZE - 1) / (2 * (size_t)(g_job_cfg.ngram - 1)))
+        ctx_max = (MAX_MSG_SIZE - 1) / (2 * (size_t)(g_job_cfg.ngram - 1));
+    size_t pos = wc_skip_separators(text, len);
+    while (pos < len) {
+        const char *ptr = text + pos;
+        size_t avail = len - pos;
+        char header[NGRAM_CONTEXT_MAX + 16];
+        size_t hlen = 0;
+        size_t limit = CHUNK_SIZE;
+        if (g_job_cfg.ngram > 1) {
+            size_t wlen;
+            hlen = ngram_header(text, pos, hist, ctx_max, header, sizeof(header), &wlen);
+            limit = ngram_text_limit(wlen);
+            if (limit > CHUNK_SIZE - hlen)
+                limit = CHUNK_SIZE - hlen;
         }
-        last->next = newp;
+        size_t actual = avail;
+        if (avail > limit) {
+            actual = wc_chunk_cut(ptr, avail, limit);
+            if (actual == 0) {
+                actual = limit; // "слово" довше за частину
+                // ...але символ UTF-8 не розриваємо
+                while (actual > 1 && ((unsigned char)ptr[actual] & 0xC0) == 0x80)
+                    actual--;
+            }
+        }
+        char *mem = malloc(CHUNK_HEADROOM + hlen + actual + 1);
+        if (!mem)
+            return -1;
+        memcpy(mem, "map", CHUNK_HEADROOM);
+        char *chunk = mem + CHUNK_HEADROOM;
+        memcpy(chunk, header, hlen);
+        memcpy(chunk + hlen, ptr, actual);
+        chunk[hlen + actual] = '\0';
+        if (chunks_push(ca, chunk) != 0) {
+            free(mem);
+            return -1;
+        }
+        pos += actual;
+        pos += wc_skip_separators(text + pos, len - pos);
     }
-
-    pthread_mutex_unlock(&g_lock);
+    return 0;
 }
 
+/*
+ * chunk_segment: ріже сегмент text[0..len) цілком; hist байтів
+ * перед text доступні для контексту n-грам. З --normalize
+ * сегмент спершу переписується словами в нижньому регістрі через
+ * один пробіл (wc_normalize), тож у частину вміщується більше
+ * слів, а воркер бачить ті самі слова.
+ */
+static int chunk_segment(const char *text, size_t len, ChunkArray *ca, size_t hist) {
+    if (!g_normalize)
+        return chunk_span(text, len, ca, hist);
+    // Історію для контексту n-грам нормалізуємо разом із сегментом
+    size_t hwin = 0;
+    if (g_job_cfg.ngram > 1)
+        hwin = hist < NGRAM_WINDOW ? hist : NGRAM_WINDOW;
+    char *norm = malloc(2 * (hwin + len) + 2);
+    if (!norm) return -1;
+    long plen = wc_normalize(text - hwin, hwin, &g_job_cfg, norm);
+    long n = -1;
+    if (plen >= 0) {
+        if (plen > 0)
+            norm[plen++] = ' ';
+        n = wc_normalize(text, len, &g_job_cfg, norm + plen);
+    }
+    int rc = (n < 0 || chunk_span(norm + plen, (size_t)n, ca, (size_t)plen) != 0) ? -1 : 0;
+    free(norm);
+    return rc;
+}
 
-// Парсит ответ MAP: "the11example111..."
-static void parse_map_reply(const char *reply) {
-    int i = 0;
-    int n = (int)strlen(reply);
+// Кінець сегмента: остання межа слова не далі за nominal (< len)
+static size_t segment_cut(const char *text, size_t len, size_t nominal) {
+    size_t from = nominal - CHUNK_SIZE;
+    size_t cut = wc_chunk_cut(text + from, len - from, CHUNK_SIZE);
+    if (cut > 0)
+        return from + cut;
+    // Без меж поблизу: ріжемо слово, але не символ UTF-8
+    while (nominal > from + 1 && ((unsigned char)text[nominal] & 0xC0) == 0x80)
+        nominal--;
+    return nominal;
+}
 
-    while (i < n) {
-        char word_buf[256];
-        int wpos = 0;
-        // собираем буквы
-        while (i < n && isalpha((unsigned char)reply[i])) {
-            if (wpos < 255) {
-                word_buf[wpos++] = reply[i];
+/*
+ * read_chunks_stream: вхід без розміру (pipe, stdin) читається
+ * буфером на сегмент і різь CHUNK_SIZE байт після нього.
+ */
+static int read_chunks_stream(FILE *in, ChunkArray *ca) {
+    size_t cap = NGRAM_WINDOW + CHUNK_SEGMENT + CHUNK_SIZE + 1;
+    char *mem = malloc(cap);
+    if (!mem) {
+        fprintf(stderr, "Not enough memory\n");
+        return -1;
+    }
+    size_t hist = 0;      // Байтів попереднього сегмента перед buf
+    char *buf = mem;      // Початок поточного сегмента
+    size_t len = 0;       // Байтів у buf
+    size_t base = 0;      // Позиція buf[0] у вході
+    size_t nominal = CHUNK_SEGMENT;
+    int rc = 0;
+
+    for (;;) {
+        // Потрібні байти до nominal включно (щоб перевірити межу)
+        size_t need = nominal - base + 1;
+        int eof = 0;
+        while (len < need) {
+            size_t n = fread(buf + len, 1, need - len, in);
+            if (n == 0) {
+                if (ferror(in)) {
+                    perror("fread");
+                    rc = -1;
+                }
+                eof = 1;
+                break;
             }
-            i++;
->>>>>>> dc6bdc5 (Test handout)
+            len += n;
         }
-        word_buf[wpos] = '\0';
-
-        int count = 0;
-<<<<<<< HEAD
-        while (*p && *p == '1') {
-            count++;
-            p++;
+        if (eof) {
+            if (chunk_segment(buf, len, ca, hist) != 0) {
+                fprintf(stderr, "Not enough memory\n");
+                rc = -1;
+            }
+            break;
         }
-
-        if (wpos > 0 && count > 0) {
-            pthread_mutex_lock(&global_omap_lock);
-            om_update(global_omap, word_buf, count);
-            pthread_mutex_unlock(&global_omap_lock);
-=======
-        // собираем подряд '1'
-        while (i < n && reply[i] == '1') {
-            count++;
-            i++;
+        size_t cut = segment_cut(buf, len, nominal - base);
+        if (chunk_segment(buf, cut, ca, hist) != 0) {
+            fprintf(stderr, "Not enough memory\n");
+            rc = -1;
+            break;
         }
+        // Хвіст сегмента лишається історією для контексту n-грам
+        size_t keep = (hist + cut < NGRAM_WINDOW) ? hist + cut : NGRAM_WINDOW;
+        memmove(mem, buf + cut - keep, keep + len - cut);
+        hist = keep;
+        buf = mem + keep;
+        len -= cut;
+        base += cut;
+        nominal += CHUNK_SEGMENT;
+    }
+
+    free(mem);
+    chunks_finish(ca);
+    return rc;
+}
 
-        if (wpos > 0 && count > 0) {
-            add_to_global_map(word_buf, count);
->>>>>>> dc6bdc5 (Test handout)
+/*
+ * Звичайний файл відображається в памʼять і ріжеться кількома
+ * потоками: кожен бере наступний сегмент і ріже його у власний
+ * список; готові сегменти публікуються в ca строго по порядку,
+ * тож map-фаза стартує, щойно готовий перший сегмент.
+ */
+typedef struct Segment {
+    size_t start, end;
+    ChunkArray chunks;          // Частини сегмента до публікації
+    int done;
+} Segment;
+
+typedef struct ChunkerCtx {
+    const char *text;
+    Segment *segs;
+    int n_segs;
+    int next;                   // Наступний сегмент для нарізання
+    int published;              // Сегменти [0, published) уже в ca
+    int failed;
+    ChunkArray *ca;
+    pthread_mutex_t lock;
+} ChunkerCtx;
+
+static void *chunker_thread_func(void *arg) {
+    ChunkerCtx *cx = (ChunkerCtx *)arg;
+    for (;;) {
+        pthread_mutex_lock(&cx->lock);
+        int k = cx->next++;
+        pthread_mutex_unlock(&cx->lock);
+        if (k >= cx->n_segs) break;
+
+        Segment *seg = &cx->segs[k];
+        int failed = chunk_segment(cx->text + seg->start, seg->end - seg->start,
+                                   &seg->chunks, seg->start) != 0;
+
+        pthread_mutex_lock(&cx->lock);
+        seg->done = 1;
+        cx->failed |= failed;
+        while (cx->published < cx->n_segs && cx->segs[cx->published].done) {
+            ChunkArray *src = &cx->segs[cx->published].chunks;
+            for (int i = 0; i < src->count; i++) {
+                if (cx->failed || chunks_push(cx->ca, src->items[i]) != 0) {
+                    chunk_release(src->items[i]);
+                    cx->failed = 1;
+                }
+            }
+            src->count = 0;
+            cx->published++;
         }
+        pthread_mutex_unlock(&cx->lock);
     }
+    return NULL;
 }
 
-<<<<<<< HEAD
-/*************************************************************
- *  Потік для map-фази: Один потік на одного воркера.
- *  Цей потік проходить по масиву частин, відбираючи "свої"
- *  за індексом (round-robin або i + k*n), надсилає їх на worker,
- *  і обробляє відповіді.
- *************************************************************/
-static void *map_thread_func(void *arg) {
-    WorkerThreadData *td = (WorkerThreadData *)arg;
-
-    // Створюємо один ZMQ_REQ сокет для цього воркера
-    void *req = zmq_socket(g_zmq_context, ZMQ_REQ);
-    if (!req) {
-        perror("zmq_socket map_thread");
-        return NULL;
+static int read_chunks_mapped(const char *text, size_t size, ChunkArray *ca) {
+    int n_segs = (int)((size + CHUNK_SEGMENT - 1) / CHUNK_SEGMENT);
+    Segment *segs = calloc(n_segs, sizeof(Segment));
+    if (!segs) {
+        fprintf(stderr, "Not enough memory\n");
+        chunks_finish(ca);
+        return -1;
     }
-    int linger = 0;
-    zmq_setsockopt(req, ZMQ_LINGER, &linger, sizeof(linger));
-    if (zmq_connect(req, td->endpoint) != 0) {
-        perror("zmq_connect map_thread");
-        zmq_close(req);
-        return NULL;
+    size_t start = 0;
+    for (int k = 0; k < n_segs; k++) {
+        size_t nominal = (size_t)(k + 1) * CHUNK_SEGMENT;
+        segs[k].start = start;
+        segs[k].end = (nominal < size) ? segment_cut(text, size, nominal) : size;
+        start = segs[k].end;
+        chunks_init(&segs[k].chunks);
     }
 
-    // Проходимо усі chunks, але опрацьовуємо лише ті, які належать
-    // цьому worker_index (наприклад, chunk #0 -> worker0, #1->worker1, ...)
-    for (int i = td->worker_index; i < td->total_chunks; i += td->n_workers) {
-        // Будуємо повідомлення "map + chunk"
-        char *chunk = td->chunk_array[i];
-        if (!chunk) continue; // safety check
-
-        char msg[MAX_MSG_SIZE];
-        snprintf(msg, sizeof(msg), "map%s", chunk);
-
-        // Надсилаємо
-        zmq_send(req, msg, strlen(msg) + 1, 0);
-
-        // Чекаємо відповіді
-        char reply[MAX_MSG_SIZE];
-        memset(reply, 0, sizeof(reply));
-        int rsize = zmq_recv(req, reply, sizeof(reply) - 1, 0);
-        if (rsize > 0) {
-            reply[rsize] = '\0';
-            // Парсимо та агрегуємо
-            aggregate_map_reply(reply);
-        }
-    }
-
-    // Закриваємо цей сокет
-=======
-// -------------------------------
-// Поток: отправляет map<chunk>, парсит ответ
-// -------------------------------
-static void *map_thread(void *arg) {
-    WorkerInfo *info = (WorkerInfo *)arg;
-
-    void *req = zmq_socket(g_zmq_context, ZMQ_REQ);
-    while (!req) {
-        sleep(0.05);
-        req = zmq_socket(g_zmq_context, ZMQ_REQ);
-    }
-    // if(!req){
-    //     perror("zmq_socket map_thread");
-    //     free(info->chunk);
-    //     free(info);
-    //     return NULL;
-    // }
-    int linger = 0;
-    zmq_setsockopt(req, ZMQ_LINGER, &linger, sizeof(linger));
+    // Потоків - скільки CPU доступно (з урахуванням --cpu-list), але
+    // не більше за сегменти
+    long n_cpu = g_affinity.count ? g_affinity.count : sysconf(_SC_NPROCESSORS_ONLN);
+    int n_threads = (n_cpu < 1) ? 1 : (n_cpu > n_segs ? n_segs : (int)n_cpu);
+
+    ChunkerCtx cx = { .text = text, .segs = segs, .n_segs = n_segs, .ca = ca };
+    pthread_mutex_init(&cx.lock, NULL);
+    pthread_t *threads = malloc(n_threads * sizeof(pthread_t));
+    int started = 0;
+    for (int i = 0; threads && i < n_threads; i++) {
+        if (pthread_create(&threads[i], NULL, chunker_thread_func, &cx) != 0)
+            break;
+        started++;
+    }
+    if (started == 0)
+        chunker_thread_func(&cx);
+    for (int i = 0; i < started; i++)
+        pthread_join(threads[i], NULL);
+    free(threads);
+    pthread_mutex_destroy(&cx.lock);
 
-    if (zmq_connect(req, info->endpoint) != 0) {
-        perror("zmq_connect map_thread");
-        zmq_close(req);
-        free(info->chunk);
-        free(info);
-        return NULL;
+    for (int k = 0; k < n_segs; k++)
+        chunks_free(&segs[k].chunks);
+    free(segs);
+    chunks_finish(ca);
+    if (cx.failed) {
+        fprintf(stderr, "Not enough memory\n");
+        return -1;
     }
+    return 0;
+}
 
-    // Формируем "map" + chunk
-    char msg[MSG_SIZE];
-    memset(msg, 0, sizeof(msg));
-    snprintf(msg, sizeof(msg), "map%s", info->chunk);
-    msg[MSG_SIZE - 1]= '\0';
-    // printf("Map request message len: %zu\n", strlen(msg));
-    zmq_send(req, msg, strlen(msg)+1, 0);
-
-    char reply[MSG_SIZE];
-    memset(reply, 0, sizeof(reply));
-    int rsize = zmq_recv(req, reply, sizeof(reply) - 1, 0);
-    if (rsize > 0) {
-        reply[rsize] = '\0';
-        parse_map_reply(reply);
-    }
-    free(info->chunk);
-    free(info);
->>>>>>> dc6bdc5 (Test handout)
-    zmq_close(req);
-    return NULL;
+/*************************************************************
+ *  read_chunks: ріже вхід на частини, не розриваючи слова.
+ *  Кожна частина одразу стає доступною потокам map. Звичайний
+ *  файл відображається в памʼять і ріжеться паралельно, решта
+ *  (pipe, stdin) читається потоком.
+ *************************************************************/
+static int read_chunks(FILE *in, ChunkArray *ca) {
+    struct stat st;
+    int fd = fileno(in);
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+        ftello(in) == 0) {
+        void *m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m != MAP_FAILED) {
+            madvise(m, st.st_size, MADV_SEQUENTIAL);
+            int rc = read_chunks_mapped(m, st.st_size, ca);
+            munmap(m, st.st_size);
+            return rc;
+        }
+    }
+    return read_chunks_stream(in, ca);
 }
 
-<<<<<<< HEAD
 /*************************************************************
- *  build_reduce_payload: будує "red..." з global_omap
+ *  Структура для даних потоку (один потік на кожного воркера)
  *************************************************************/
-=======
-// -------------------------------
-// Формируем REDUCE: "red" + (word + '1'*count)
-// -------------------------------
-// static void build_reduce_payload(char *out, size_t outsize) {
-//     memset(out, 0, outsize);
-//     strcpy(out, "red");
-//     size_t pos = 3;
-
-//     pthread_mutex_lock(&g_lock);
-//     for (Pair *p = g_map_results; p != NULL; p = p->next) {
-//         const char *w = p->word;
-//         int wlen = (int)strlen(w);
-//         if (pos + wlen < outsize - 1) {
-//             memcpy(out + pos, w, wlen);
-//             pos += wlen;
-//         }
-//         for (int i = 0; i < p->count; i++) {
-//             if (pos < outsize - 1) {
-//                 out[pos++] = '1';
-//             } else {
-//                 break;
-//             }
-//         }
-//     }
-//     pthread_mutex_unlock(&g_lock);
-// }
->>>>>>> dc6bdc5 (Test handout)
-static void build_reduce_payload(char *out, size_t outsize) {
-    memset(out, 0, outsize);
-    strcpy(out, "red");
-    size_t pos = 3;
-<<<<<<< HEAD
+typedef struct WorkerThreadData {
+    int worker_index;           // Індекс воркера (0..n-1)
+    struct Connection *conn;    // Зʼєднання з воркером (менеджер зʼєднань)
+    ChunkArray *chunk_array;    // Спільний масив частин (росте під час читання)
+    int n_workers;              // Кількість воркерів
+    struct WorkerThreadData *all; // Дані всіх потоків (для перехоплення частин)
+    // Поля нижче захищені g_spec.lock
+    int next;                   // Наступна "своя" частина (i + k*n)
+    int slow;                   // 1, поки запит до воркера прострочено
+    int exhausted;              // 1, коли своїх частин більше немає
+    int batch;                  // Поточний розмір пакета (адаптивний)
+    int batch_max;              // Верхня межа пакета (--batch)
+} WorkerThreadData;
 
-    pthread_mutex_lock(&global_omap_lock);
-    OMNode *curr = global_omap->order_head;
-    OMNode *prev = NULL;
-    while (curr && pos < outsize - 1) {
-        int wlen = (int)strlen(curr->word);
-        if (pos + wlen >= outsize - 1)
-            break;
-        memcpy(out + pos, curr->word, wlen);
-        pos += wlen;
+/*************************************************************
+ *  ВІДСОРТОВАНІ СЕРІЇ (--sorted-runs)
+ *
+ *  Воркери повертають результат map, відсортований за словом
+ *  (налаштування "sorted"), і кожна відповідь зберігається як
+ *  серія (run). Серії зливаються k-way злиттям через дерево
+ *  переможених (loser tree): кожні RUN_FANIN серій одного рівня
+ *  стають однією серією наступного рівня (як у LSM-дереві), а
+ *  наприкінці всі рівні зливаються у фінальний потік
+ *  (слово, сума) за зростанням слова. Хеш-таблиці та reduce на
+ *  воркері не потрібні; доступ до памʼяті - послідовний.
+ *************************************************************/
+#define RUN_FANIN 64
+#define RUN_LEVELS 8
 
-        while (curr->count > 0 && pos < outsize - 1) {
-            out[pos++] = '1';
-            curr->count--;
-        }
+typedef struct Run {
+    char *data;                 // "word111..." або "word12..." з '\0' у кінці
+    int decimal;                // 1: десяткові числа (злиті серії), 0: унарні
+} Run;
 
-        if (curr->count == 0) {
-            char *temp_key = strdup(curr->word);
-            if (!prev) {
-                global_omap->order_head = curr->order_next;
-                curr = global_omap->order_head;
-            } else {
-                prev->order_next = curr->order_next;
-                curr = prev->order_next;
-            }
-            om_remove(global_omap, temp_key);
-            free(temp_key);
+typedef struct RunLevel {
+    Run items[RUN_FANIN];
+    int count;
+} RunLevel;
+
+static int g_sorted_runs = 0;
+static RunLevel g_runs[RUN_LEVELS];
+static pthread_mutex_t g_runs_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Курсор серії: поточне слово та його лічильник
+typedef struct RunCursor {
+    const char *p;
+    const char *end;            // Кінець серії ('\0')
+    int decimal;
+    int done;
+    char word[256];
+    long count;
+} RunCursor;
+
+static void cursor_next(RunCursor *c) {
+    while (c->p < c->end) {
+        size_t wlen = wc_word_span(c->p, (size_t)(c->end - c->p));
+        size_t keep = wc_word_clip(c->p, wlen);
+        memcpy(c->word, c->p, keep);
+        c->word[keep] = '\0';
+        c->p += wlen;
+        long count = 0;
+        if (c->decimal) {
+            while (isdigit((unsigned char)*c->p))
+                count = count * 10 + (*c->p++ - '0');
         } else {
-            prev = curr;
-            curr = curr->order_next;
+            size_t run = wc_ones_span(c->p, (size_t)(c->end - c->p));
+            count = (long)run;
+            c->p += run;
+            if (count == 0 && c->p < c->end)
+                c->p++; // Неочікувана цифра
+        }
+        if (keep > 0 && count > 0) {
+            c->count = count;
+            return;
         }
     }
-    pthread_mutex_unlock(&global_omap_lock);
-    out[outsize - 1] = '\0';
+    c->done = 1;
 }
 
-/*************************************************************
- *  parse_reduce_reply: розбирає "word<number>" і оновлює
- *  глобальну фінальну HashMap
- *************************************************************/
-static void parse_reduce_reply(const char *reply) {
-    int i = 0;
-    int n = (int)strlen(reply);
-    while (i < n) {
-        char wbuf[256];
-        int wpos = 0;
-        while (i < n && isalpha((unsigned char)reply[i])) {
-            if (wpos < 255)
-                wbuf[wpos++] = reply[i];
-            i++;
-        }
-        wbuf[wpos] = '\0';
+/*
+ * Дерево переможених над k курсорами: листки k..2k-1 - курсори,
+ * tree[1..k-1] - переможені у внутрішніх вузлах, tree[0] -
+ * загальний переможець (найменше слово). Після кроку переможця
+ * перегравання йде лише шляхом від його листка до кореня.
+ */
+typedef struct LoserTree {
+    int k;
+    int *tree;
+    RunCursor *cur;
+} LoserTree;
+
+// Чи йде курсор a перед b (вичерпані - наприкінці)
+static int lt_before(const LoserTree *lt, int a, int b) {
+    const RunCursor *x = &lt->cur[a];
+    const RunCursor *y = &lt->cur[b];
+    if (x->done) return 0;
+    if (y->done) return 1;
+    return strcmp(x->word, y->word) < 0;
+}
 
-        char nbuf[64];
-        int np = 0;
-        while (i < n && isdigit((unsigned char)reply[i])) {
-            if (np < 63)
-                nbuf[np++] = reply[i];
-            i++;
-        }
-        nbuf[np] = '\0';
+static int lt_build(LoserTree *lt, int node) {
+    if (node >= lt->k) return node - lt->k;
+    int l = lt_build(lt, 2 * node);
+    int r = lt_build(lt, 2 * node + 1);
+    if (lt_before(lt, r, l)) {
+        lt->tree[node] = l;
+        return r;
+    }
+    lt->tree[node] = r;
+    return l;
+}
 
-        if (wpos > 0 && np > 0) {
-            int c = atoi(nbuf);
-            pthread_mutex_lock(&global_hash_lock);
-            hm_update(global_hash_map, wbuf, c);
-            pthread_mutex_unlock(&global_hash_lock);
-=======
-    pthread_mutex_lock(&g_lock);
-    Pair *prev = NULL; // To track the previous node for deletion if count reaches 0
-    Pair *p = g_map_results;
-
-    while (p != NULL) {
-        const char *w = p->word;
-
-        int wlen = (int)strlen(w);
-        // Add the word to the payload if it fits
-        if (pos + wlen < outsize - 1) {
-            memcpy(out + pos, w, wlen);
-            pos += wlen;
-        } else {
-            break; // Not enough space for this word, stop here
-        }
-        // Add the '1's for the current word
-        while (p->count > 0 && pos < outsize - 1) {
-            out[pos++] = '1';
-            p->count--;
+static void lt_replay(LoserTree *lt) {
+    int w = lt->tree[0];
+    for (int node = (w + lt->k) / 2; node >= 1; node /= 2) {
+        if (lt_before(lt, lt->tree[node], w)) {
+            int t = lt->tree[node];
+            lt->tree[node] = w;
+            w = t;
         }
+    }
+    lt->tree[0] = w;
+}
 
-        // If this word is fully processed, remove it from the list
-        if (p->count == 0) {
-            if (prev == NULL) {
-                // Head of the list
-                g_map_results = p->next;
-                free(p->word);
-                free(p);
-                p = g_map_results;
-            } else {
-                // Middle or end of the list
-                prev->next = p->next;
-                free(p->word);
-                free(p);
-                p = prev->next;
-            }
+typedef void (*merge_emit_fn)(const char *word, long count, void *ctx);
+
+/*
+ * merge_runs: зливає n серій і викликає emit для кожного слова
+ * (за зростанням) із сумою лічильників. Повертає 0 або -1.
+ */
+static int merge_runs(const Run *runs, int n, merge_emit_fn emit, void *ctx) {
+    if (n == 0) return 0;
+    RunCursor *cur = malloc(n * sizeof(RunCursor));
+    int *tree = malloc(n * sizeof(int));
+    if (!cur || !tree) {
+        free(cur);
+        free(tree);
+        return -1;
+    }
+    for (int i = 0; i < n; i++) {
+        cur[i].p = runs[i].data;
+        cur[i].end = runs[i].data + strlen(runs[i].data);
+        cur[i].decimal = runs[i].decimal;
+        cur[i].done = 0;
+        cursor_next(&cur[i]);
+    }
+    LoserTree lt = { n, tree, cur };
+    tree[0] = lt_build(&lt, 1);
+
+    char word[256] = "";
+    long sum = 0;
+    while (!cur[tree[0]].done) {
+        RunCursor *w = &cur[tree[0]];
+        if (sum > 0 && strcmp(word, w->word) == 0) {
+            sum += w->count;
         } else {
-            prev = p;
-            p = p->next;
+            if (sum > 0) emit(word, sum, ctx);
+            strcpy(word, w->word);
+            sum = w->count;
         }
+        cursor_next(w);
+        lt_replay(&lt);
     }
-    pthread_mutex_unlock(&g_lock);
+    if (sum > 0) emit(word, sum, ctx);
+    free(cur);
+    free(tree);
+    return 0;
 }
 
-
-// Добавляет (word, c) в g_final_list
-static void add_to_final_list(const char *word, int c) {
-    pthread_mutex_lock(&g_final_lock);
-    FinalPair *fp = g_final_list;
-    while (fp) {
-        if (strcmp(fp->word, word) == 0) {
-            fp->count += c;
-            pthread_mutex_unlock(&g_final_lock);
+// Збирає злиту серію "word12word3..." у буфер, що росте
+typedef struct RunBuilder {
+    char *data;
+    size_t len;
+    size_t cap;
+    int failed;
+} RunBuilder;
+
+static void builder_emit(const char *word, long count, void *ctx) {
+    RunBuilder *b = ctx;
+    size_t need = b->len + strlen(word) + 24;
+    if (need > b->cap) {
+        size_t new_cap = b->cap ? b->cap * 2 : 4096;
+        while (new_cap < need) new_cap *= 2;
+        char *tmp = realloc(b->data, new_cap);
+        if (!tmp) {
+            b->failed = 1;
             return;
         }
-        fp = fp->next;
+        b->data = tmp;
+        b->cap = new_cap;
     }
-    FinalPair *newf = malloc(sizeof(*newf));
-    newf->word = strdup(word);
-    newf->count = c;
-    newf->next = g_final_list;
-    g_final_list = newf;
-    pthread_mutex_unlock(&g_final_lock);
+    b->len += sprintf(b->data + b->len, "%s%ld", word, count);
 }
 
-// Парсит REDUCE ответ: "the2example2..."
-static void parse_reduce_reply(const char *reply) {
-    int i = 0;
-    int n = (int)strlen(reply);
-
-    while (i < n) {
-        char word_buf[256];
-        int wpos = 0;
-        while (i < n && isalpha((unsigned char)reply[i])) {
-            if (wpos < 255) {
-                word_buf[wpos++] = reply[i];
-            }
-            i++;
+/*
+ * runs_push: додає серію на рівень level. Коли рівень
+ * заповнюється, потік, що його заповнив, забирає всі серії,
+ * зливає їх поза мʼютексом і кладе результат на рівень вище.
+ */
+static void runs_push(Run run, int level) {
+    for (;;) {
+        pthread_mutex_lock(&g_runs_lock);
+        RunLevel *lv = &g_runs[level];
+        lv->items[lv->count++] = run;
+        if (lv->count < RUN_FANIN) {
+            pthread_mutex_unlock(&g_runs_lock);
+            return;
         }
-        word_buf[wpos] = '\0';
-
-        char num_buf[64];
-        int np = 0;
-        while (i < n && isdigit((unsigned char)reply[i])) {
-            if (np < 63) {
-                num_buf[np++] = reply[i];
-            }
-            i++;
+        Run batch[RUN_FANIN];
+        memcpy(batch, lv->items, sizeof(batch));
+        lv->count = 0;
+        pthread_mutex_unlock(&g_runs_lock);
+
+        RunBuilder b = { NULL, 0, 0, 0 };
+        if (merge_runs(batch, RUN_FANIN, builder_emit, &b) != 0 || b.failed || !b.data) {
+            fprintf(stderr, "Not enough memory to merge runs\n");
+            exit(1);
         }
-        num_buf[np] = '\0';
-
-        if (wpos > 0 && np > 0) {
-            int c = atoi(num_buf);
+        for (int i = 0; i < RUN_FANIN; i++)
+            free(batch[i].data);
+        run.data = b.data;
+        run.decimal = 1;
+        if (level < RUN_LEVELS - 1)
+            level++;
+    }
+}
 
-            add_to_final_list(word_buf, c);
->>>>>>> dc6bdc5 (Test handout)
+// Збирає фінальні (слово, сума) у масив FPNode
+typedef struct FinalList {
+    FPNode *items;
+    int count;
+    int capacity;
+    int failed;
+} FinalList;
+
+static void final_emit(const char *word, long count, void *ctx) {
+    FinalList *fl = ctx;
+    if (fl->count == fl->capacity) {
+        int new_cap = fl->capacity ? fl->capacity * 2 : 1024;
+        FPNode *tmp = realloc(fl->items, new_cap * sizeof(FPNode));
+        if (!tmp) {
+            fl->failed = 1;
+            return;
         }
+        fl->items = tmp;
+        fl->capacity = new_cap;
     }
+    // Після злиття кожне слово трапляється один раз: таблиця не потрібна
+    fl->items[fl->count++] = (FPNode){ arena_append(word), (int)count };
 }
 
-<<<<<<< HEAD
-/*************************************************************
- *  Компаратор для фінального сортування
- *************************************************************/
-static int cmp_final(const void *a, const void *b) {
-    const FPNode *fa = *(const FPNode **)a;
-    const FPNode *fb = *(const FPNode **)b;
-    if (fa->count > fb->count) return -1;
-    if (fa->count < fb->count) return 1;
-    return strcmp(fa->word, fb->word);
+/*
+ * runs_finish: зливає серії всіх рівнів (після map-фази) у
+ * список слів і звільняє серії. Повертає 0 або -1.
+ */
+static int runs_finish(FinalList *fl) {
+    Run all[RUN_FANIN * RUN_LEVELS];
+    int n = 0;
+    for (int l = 0; l < RUN_LEVELS; l++) {
+        for (int i = 0; i < g_runs[l].count; i++)
+            all[n++] = g_runs[l].items[i];
+        g_runs[l].count = 0;
+    }
+    int rc = merge_runs(all, n, final_emit, fl);
+    for (int i = 0; i < n; i++)
+        free(all[i].data);
+    return (rc != 0 || fl->failed) ? -1 : 0;
 }
 
 /*************************************************************
- *  MAIN
+ *  aggregate_map_reply: розбирає "word111word111..." та
+ *  оновлює global_omap під мʼютексом. Частина chunk_idx
+ *  позначається завершеною в тій самій критичній секції;
+ *  повторна відповідь для вже завершеної частини (після
+ *  спекулятивного перевиконання) відкидається. Повертає 1,
+ *  якщо відповідь враховано, і 0 для дубліката.
  *************************************************************/
-int main(int argc, char *argv[]) {
-=======
-// Сортируем FinalPair: убывание по частоте, потом алфавит
-static int cmpfunc(const void *a, const void *b) {
-    const FinalPair *fa = *(const FinalPair **)a;
-    const FinalPair *fb = *(const FinalPair **)b;
-    if (fa->count > fb->count) return -1;
-    if (fa->count < fb->count) return +1;
-    return strcmp(fa->word, fb->word);
-}
-
-// -----------------------------------------------------------------------------
-// MAIN Distributor
-// -----------------------------------------------------------------------------
-int main(int argc, char *argv[])
-{
->>>>>>> dc6bdc5 (Test handout)
-    if (argc < 3) {
-        fprintf(stderr, "Usage: %s <file.txt> <port1> [<port2> ...]\n", argv[0]);
+static int aggregate_map_reply(int chunk_idx, const char *reply) {
+    pthread_mutex_lock(&global_omap_lock);
+    if (chunk_done_locked(chunk_idx)) {
+        pthread_mutex_unlock(&global_omap_lock);
+        return 0;
+    }
+    if (g_sorted_runs) {
+        // Відповідь уже відсортована: зберігаємо її як серію
+        chunk_mark_done_locked(chunk_idx);
+        pthread_mutex_unlock(&global_omap_lock);
+        Run run = { strdup(reply), 0 };
+        if (!run.data) {
+            fprintf(stderr, "Not enough memory\n");
+            exit(1);
+        }
+        runs_push(run, 0);
         return 1;
     }
-<<<<<<< HEAD
-    int n_workers = argc - 2;
+    // Слова - відрізки відповіді, серії '1' рахуються блоками
+    size_t n = strlen(reply);
+    size_t i = 0;
+    while (i < n) {
+        size_t start = i;
+        // Слово - усе до першої цифри (літери ASCII або UTF-8)
+        const char *word = reply + i;
+        size_t wlen = wc_word_span(word, n - i);
+        i += wlen;
+        wlen = wc_word_clip(word, wlen);
+
+        size_t count = wc_ones_span(reply + i, n - i);
+        i += count;
+
+        if (wlen > 0 && count > 0) {
+            om_update(global_omap, intern_len(word, wlen), (int)count);
+        }
+        if (i == start)
+            i++; // Неочікувана цифра: пропускаємо
+    }
+    chunk_mark_done_locked(chunk_idx);
+    pthread_mutex_unlock(&global_omap_lock);
+    return 1;
+}
+
+/*************************************************************
+ *  КОНТРОЛЬНІ ТОЧКИ (checkpoint / --resume)
+ *
+ *  Формат файлу (little-endian, компактний двійковий):
+ *    "WCCP"  u32 версія  u32 CHUNK_SIZE  u64 відбиток налаштувань
+ *    u32 к-сть бітів  u64 к-сть слів
+ *    бітова мапа завершених частин (ceil(бітів/8) байт)
+ *    для кожного слова: u16 довжина, байти слова, u32 count
+ *    u64 FNV-1a контрольна сума всього попереднього
+ *  Файл пишеться у "<path>.tmp" і атомарно перейменовується.
+ *  Відновлення припускає той самий вхід (ті самі частини).
+ *************************************************************/
+#define CKPT_MAGIC "WCCP"
+#define CKPT_VERSION 3
+
+static uint64_t fnv1a64(const unsigned char *data, size_t len) {
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        h ^= data[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static void put_u16(unsigned char **p, uint16_t v) {
+    (*p)[0] = (unsigned char)v;
+    (*p)[1] = (unsigned char)(v >> 8);
+    *p += 2;
+}
+
+static void put_u32(unsigned char **p, uint32_t v) {
+    for (int i = 0; i < 4; i++) (*p)[i] = (unsigned char)(v >> (8 * i));
+    *p += 4;
+}
+
+static void put_u64(unsigned char **p, uint64_t v) {
+    for (int i = 0; i < 8; i++) (*p)[i] = (unsigned char)(v >> (8 * i));
+    *p += 8;
+}
+
+static uint64_t get_le(const unsigned char *p, int nbytes) {
+    uint64_t v = 0;
+    for (int i = nbytes - 1; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+/*
+ * checkpoint_save: знімає знімок global_omap і бітової мапи під
+ * мʼютексом у памʼять, а запис на диск робить уже без блокування.
+ */
+static int checkpoint_save(const char *path) {
+    pthread_mutex_lock(&global_omap_lock);
+    uint64_t n_words = 0;
+    size_t size = 4 + 4 + 4 + 8 + 4 + 8 + (size_t)g_done_nbits / 8 + 8;
+    for (OMNode *n = global_omap->order_head; n; n = n->order_next) {
+        n_words++;
+        size += 2 + strlen(WORD(n->word)) + 4;
+    }
+    unsigned char *buf = malloc(size);
+    if (!buf) {
+        pthread_mutex_unlock(&global_omap_lock);
+        fprintf(stderr, "checkpoint: not enough memory\n");
+        return -1;
+    }
+    unsigned char *p = buf;
+    memcpy(p, CKPT_MAGIC, 4);
+    p += 4;
+    put_u32(&p, CKPT_VERSION);
+    put_u32(&p, CHUNK_SIZE);
+    put_u64(&p, g_job_tag);
+    put_u32(&p, (uint32_t)g_done_nbits);
+    put_u64(&p, n_words);
+    if (g_done_nbits > 0) {
+        memcpy(p, g_done_bits, g_done_nbits / 8);
+        p += g_done_nbits / 8;
+    }
+    for (OMNode *n = global_omap->order_head; n; n = n->order_next) {
+        size_t wlen = strlen(WORD(n->word));
+        put_u16(&p, (uint16_t)wlen);
+        memcpy(p, WORD(n->word), wlen);
+        p += wlen;
+        put_u32(&p, (uint32_t)n->count);
+    }
+    pthread_mutex_unlock(&global_omap_lock);
+    put_u64(&p, fnv1a64(buf, (size_t)(p - buf)));
+
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE *f = fopen(tmp_path, "wb");
+    if (!f) {
+        perror("checkpoint fopen");
+        free(buf);
+        return -1;
+    }
+    int ok = fwrite(buf, 1, size, f) == size;
+    ok = ok && fflush(f) == 0 && fsync(fileno(f)) == 0;
+    ok = (fclose(f) == 0) && ok;
+    free(buf);
+    if (!ok || rename(tmp_path, path) != 0) {
+        perror("checkpoint write");
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * checkpoint_load: перевіряє файл і наповнює global_omap та
+ * бітову мапу завершених частин. Повертає 0 або -1.
+ */
+static int checkpoint_load(const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror("checkpoint fopen");
+        return -1;
+    }
+    unsigned char *buf = NULL;
+    size_t size = 0, cap = 0;
+    for (;;) {
+        if (size == cap) {
+            cap = cap ? cap * 2 : READ_BUF_SIZE;
+            unsigned char *tmp = realloc(buf, cap);
+            if (!tmp) {
+                free(buf);
+                fclose(f);
+                return -1;
+            }
+            buf = tmp;
+        }
+        size_t n = fread(buf + size, 1, cap - size, f);
+        if (n == 0) break;
+        size += n;
+    }
+    fclose(f);
+
+    const size_t header = 4 + 4 + 4 + 8 + 4 + 8;
+    if (size < header + 8 || memcmp(buf, CKPT_MAGIC, 4) != 0 ||
+        get_le(buf + 4, 4) != CKPT_VERSION || get_le(buf + 8, 4) != CHUNK_SIZE ||
+        get_le(buf + 12, 8) != g_job_tag ||
+        get_le(buf + size - 8, 8) != fnv1a64(buf, size - 8)) {
+        fprintf(stderr, "checkpoint: %s is corrupt or incompatible\n", path);
+        free(buf);
+        return -1;
+    }
+    uint32_t nbits = (uint32_t)get_le(buf + 20, 4);
+    uint64_t n_words = get_le(buf + 24, 8);
+    const unsigned char *p = buf + header;
+    const unsigned char *end = buf + size - 8;
+    if ((size_t)(end - p) < nbits / 8) {
+        free(buf);
+        return -1;
+    }
+
+    pthread_mutex_lock(&global_omap_lock);
+    for (uint32_t i = 0; i < nbits; i++) {
+        if ((p[i / 8] >> (i % 8)) & 1)
+            chunk_mark_done_locked((int)i);
+    }
+    p += nbits / 8;
+    int rc = 0;
+    for (uint64_t i = 0; i < n_words; i++) {
+        if (end - p < 2) { rc = -1; break; }
+        size_t wlen = (size_t)get_le(p, 2);
+        p += 2;
+        if ((size_t)(end - p) < wlen + 4 || wlen > 255) { rc = -1; break; }
+        char word[256];
+        memcpy(word, p, wlen);
+        word[wlen] = '\0';
+        p += wlen;
+        om_update(global_omap, intern(word), (int)get_le(p, 4));
+        p += 4;
+    }
+    pthread_mutex_unlock(&global_omap_lock);
+    free(buf);
+    if (rc != 0)
+        fprintf(stderr, "checkpoint: %s is truncated\n", path);
+    return rc;
+}
+
+/*
+ * Потік, що періодично зберігає контрольну точку, доки
+ * map-фаза не завершиться (stop = 1).
+ */
+typedef struct CheckpointCtx {
+    const char *path;
+    int interval;               // Інтервал у секундах
+    int stop;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+} CheckpointCtx;
+
+static void *checkpoint_thread_func(void *arg) {
+    CheckpointCtx *ctx = (CheckpointCtx *)arg;
+    pthread_mutex_lock(&ctx->lock);
+    while (!ctx->stop) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += ctx->interval;
+        int rc = 0;
+        while (!ctx->stop && rc != ETIMEDOUT)
+            rc = pthread_cond_timedwait(&ctx->cond, &ctx->lock, &deadline);
+        if (ctx->stop) break;
+        pthread_mutex_unlock(&ctx->lock);
+        checkpoint_save(ctx->path);
+        pthread_mutex_lock(&ctx->lock);
+    }
+    pthread_mutex_unlock(&ctx->lock);
+    return NULL;
+}
+
+/*************************************************************
+ *  КЕШ РЕЗУЛЬТАТІВ ЧАСТИН (--cache)
+ *
+ *  Кожна частина хешується 64-бітним хешем; якщо такий хеш є
+ *  у кеші попереднього запуску, відповідь map береться з
+ *  файлу (mmap) і на воркер нічого не надсилається.
+ *
+ *  Формат файлу (little-endian):
+ *    "WCRC"  u32 версія  u64 к-сть слотів індексу (степінь 2)
+ *    слоти: u64 хеш (0 = порожньо), u64 зсув, u32 довжина, u32 0
+ *    дані: відповіді map разом із завершальним '\0'
+ *  Після запуску файл перезаписується атомарно і містить лише
+ *  частини цього запуску, тож кеш не росте безмежно.
+ *************************************************************/
+#define CACHE_MAGIC "WCRC"
+#define CACHE_VERSION 1
+#define CACHE_SEED 0x5eed0f0c4c4e5eedULL
+#define CACHE_HEADER_SIZE 16
+#define CACHE_SLOT_SIZE 24
+
+__extension__ typedef unsigned __int128 uint128_t;
+
+static uint64_t mix64(uint64_t a, uint64_t b) {
+    uint128_t r = (uint128_t)a * b;
+    return (uint64_t)r ^ (uint64_t)(r >> 64);
+}
+
+typedef struct CacheEntry {
+    uint64_t hash;
+    const char *reply;          // Відповідь map із '\0'
+    uint32_t len;               // Довжина разом із '\0'
+    int owned;                  // 1, якщо reply виділено malloc
+} CacheEntry;
+
+typedef struct ChunkCache {
+    const char *path;           // NULL, якщо кеш вимкнено
+    unsigned char *map;         // mmap попереднього файлу (або NULL)
+    size_t map_size;
+    uint64_t slots;             // К-сть слотів індексу у map
+    CacheEntry *entries;        // Записи для нового файлу
+    size_t n_entries, cap_entries;
+    long hits, misses;
+    pthread_mutex_t lock;
+} ChunkCache;
+
+static ChunkCache g_cache = { .path = NULL, .lock = PTHREAD_MUTEX_INITIALIZER };
+
+// Відкриває та перевіряє файл кешу; відсутній чи пошкоджений файл
+// означає порожній кеш
+static void cache_open(ChunkCache *c, const char *path) {
+    c->path = path;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= CACHE_HEADER_SIZE) {
+        void *m = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (m != MAP_FAILED) {
+            unsigned char *b = m;
+            uint64_t slots = get_le(b + 8, 8);
+            if (memcmp(b, CACHE_MAGIC, 4) == 0 && get_le(b + 4, 4) == CACHE_VERSION &&
+                slots > 0 && (slots & (slots - 1)) == 0 &&
+                slots <= ((size_t)st.st_size - CACHE_HEADER_SIZE) / CACHE_SLOT_SIZE) {
+                c->map = b;
+                c->map_size = st.st_size;
+                c->slots = slots;
+            } else {
+                fprintf(stderr, "cache: ignoring incompatible %s\n", path);
+                munmap(m, st.st_size);
+            }
+        }
+    }
+    close(fd);
+}
+
+// Шукає відповідь за хешем у попередньому файлі кешу
+static const char *cache_lookup(const ChunkCache *c, uint64_t hash, uint32_t *len) {
+    if (!c->map) return NULL;
+    uint64_t mask = c->slots - 1;
+    for (uint64_t i = hash & mask, n = 0; n < c->slots; i = (i + 1) & mask, n++) {
+        const unsigned char *slot = c->map + CACHE_HEADER_SIZE + i * CACHE_SLOT_SIZE;
+        uint64_t h = get_le(slot, 8);
+        if (h == 0) return NULL;
+        if (h != hash) continue;
+        uint64_t off = get_le(slot + 8, 8);
+        uint32_t l = (uint32_t)get_le(slot + 16, 4);
+        if (l == 0 || off > c->map_size || l > c->map_size - off ||
+            c->map[off + l - 1] != '\0')
+            return NULL;
+        *len = l;
+        return (const char *)c->map + off;
+    }
+    return NULL;
+}
+
+// Запамʼятовує результат частини для запису нового файлу кешу
+static void cache_remember(ChunkCache *c, uint64_t hash, const char *reply,
+                           uint32_t len, int hit) {
+    char *copy = NULL;
+    if (!hit) {
+        copy = malloc(len);
+        if (!copy) return;
+        memcpy(copy, reply, len);
+    }
+    pthread_mutex_lock(&c->lock);
+    if (c->n_entries == c->cap_entries) {
+        size_t new_cap = c->cap_entries ? c->cap_entries * 2 : 1024;
+        CacheEntry *tmp = realloc(c->entries, new_cap * sizeof(CacheEntry));
+        if (!tmp) {
+            pthread_mutex_unlock(&c->lock);
+            free(copy);
+            return;
+        }
+        c->entries = tmp;
+        c->cap_entries = new_cap;
+    }
+    CacheEntry *e = &c->entries[c->n_entries++];
+    e->hash = hash;
+    e->reply = hit ? reply : copy;
+    e->len = len;
+    e->owned = !hit;
+    if (hit) c->hits++; else c->misses++;
+    pthread_mutex_unlock(&c->lock);
+}
+
+// Записує новий файл кешу ("<path>.tmp" + rename)
+static int cache_save(ChunkCache *c) {
+    uint64_t slots = 16;
+    while (slots < c->n_entries * 2) slots *= 2;
+    size_t data_off = CACHE_HEADER_SIZE + slots * CACHE_SLOT_SIZE;
+    unsigned char *index = calloc(1, data_off);
+    if (!index) return -1;
+
+    unsigned char *p = index;
+    memcpy(p, CACHE_MAGIC, 4);
+    p += 4;
+    put_u32(&p, CACHE_VERSION);
+    put_u64(&p, slots);
+
+    uint64_t off = data_off;
+    for (size_t i = 0; i < c->n_entries; i++) {
+        CacheEntry *e = &c->entries[i];
+        uint64_t j = e->hash & (slots - 1);
+        unsigned char *slot;
+        int dup = 0;
+        for (;;) {
+            slot = index + CACHE_HEADER_SIZE + j * CACHE_SLOT_SIZE;
+            uint64_t h = get_le(slot, 8);
+            if (h == 0) break;
+            if (h == e->hash) { dup = 1; break; }
+            j = (j + 1) & (slots - 1);
+        }
+        if (dup) {
+            e->len = 0; // та сама частина вже є в індексі
+            continue;
+        }
+        unsigned char *q = slot;
+        put_u64(&q, e->hash);
+        put_u64(&q, off);
+        put_u32(&q, e->len);
+        off += e->len;
+    }
+
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", c->path);
+    FILE *f = fopen(tmp_path, "wb");
+    if (!f) {
+        perror("cache fopen");
+        free(index);
+        return -1;
+    }
+    int ok = fwrite(index, 1, data_off, f) == data_off;
+    for (size_t i = 0; ok && i < c->n_entries; i++) {
+        if (c->entries[i].len > 0)
+            ok = fwrite(c->entries[i].reply, 1, c->entries[i].len, f) == c->entries[i].len;
+    }
+    ok = ok && fflush(f) == 0;
+    ok = (fclose(f) == 0) && ok;
+    free(index);
+    if (!ok || rename(tmp_path, c->path) != 0) {
+        perror("cache write");
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+static void cache_close(ChunkCache *c) {
+    for (size_t i = 0; i < c->n_entries; i++) {
+        if (c->entries[i].owned)
+            free((char *)c->entries[i].reply);
+    }
+    free(c->entries);
+    if (c->map)
+        munmap(c->map, c->map_size);
+}
+
+/*************************************************************
+ *  ЧЕРГА ВІДПОВІДЕЙ MAP (MPSC) І ПОТІК АГРЕГАЦІЇ
+ *
+ *  Map-потоки не розбирають відповіді самі: кадр копіюється у
+ *  вільну комірку кільця, і потік одразу повертається до
+ *  мережі. Окремий потік агрегації забирає комірки по черзі,
+ *  викликає aggregate_map_reply і запамʼятовує результат у
+ *  кеші, тож global_omap і кеш змінює лише він.
+ *
+ *  Кільце - обмежена черга Вʼюкова: кожна комірка має номер
+ *  послідовності, виробник займає комірку CAS-ом позиції запису
+ *  й публікує її записом номера, тож на шляху map-потоків немає
+ *  мʼютексів. Буфери комірок виділяються один раз і
+ *  використовуються повторно. Споживач чекає на семафорі.
+ *************************************************************/
+#define REPLY_RING_SIZE 256     // Комірок у кільці (степінь двійки)
+
+typedef struct ReplySlot {
+    atomic_size_t seq;          // == позиція: вільна; == позиція + 1: заповнена
+    int chunk_idx;              // -1: сигнал завершення для агрегатора
+    uint64_t chunk_hash;        // Хеш частини для кешу (0 - кеш вимкнено)
+    const char *cached;         // Відповідь із файлу кешу (без копіювання) або NULL
+    uint32_t len;               // Довжина відповіді разом із '\0'
+    char data[MAX_MSG_SIZE];    // Копія кадру від воркера
+} ReplySlot;
+
+typedef struct ReplyRing {
+    ReplySlot *slots;
+    atomic_size_t head;         // Наступна позиція запису (виробники)
+    size_t tail;                // Наступна позиція читання (лише агрегатор)
+    sem_t ready;                // К-сть поставлених у чергу відповідей
+} ReplyRing;
+
+static ReplyRing g_replies;
+
+static int reply_ring_init(ReplyRing *r) {
+    r->slots = malloc(REPLY_RING_SIZE * sizeof(ReplySlot));
+    if (!r->slots) return -1;
+    for (size_t i = 0; i < REPLY_RING_SIZE; i++)
+        atomic_init(&r->slots[i].seq, i);
+    atomic_init(&r->head, 0);
+    r->tail = 0;
+    return sem_init(&r->ready, 0, 0);
+}
+
+static void reply_ring_destroy(ReplyRing *r) {
+    sem_destroy(&r->ready);
+    free(r->slots);
+}
+
+/*
+ * reply_push: ставить у чергу відповідь частини chunk_idx
+ * довжиною len (без '\0'). Кадр reply копіюється в комірку;
+ * відповідь із кешу (cached != NULL) передається вказівником.
+ * Якщо кільце заповнене, виробник поступається процесором,
+ * доки агрегатор не звільнить комірку.
+ */
+static void reply_push(ReplyRing *r, int chunk_idx, uint64_t chunk_hash,
+                       const char *reply, size_t len, const char *cached) {
+    size_t pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+    ReplySlot *slot;
+    for (;;) {
+        slot = &r->slots[pos & (REPLY_RING_SIZE - 1)];
+        size_t seq = atomic_load_explicit(&slot->seq, memory_order_acquire);
+        intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&r->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        } else {
+            if (diff < 0)
+                sched_yield(); // Кільце заповнене
+            pos = atomic_load_explicit(&r->head, memory_order_relaxed);
+        }
+    }
+    if (len > MAX_MSG_SIZE - 1)
+        len = MAX_MSG_SIZE - 1; // Обрізаний кадр (zmq_recv повертає повну довжину)
+    slot->chunk_idx = chunk_idx;
+    slot->chunk_hash = chunk_hash;
+    slot->cached = cached;
+    slot->len = (uint32_t)len + 1;
+    if (!cached && reply) {
+        memcpy(slot->data, reply, len);
+        slot->data[len] = '\0';
+    }
+    atomic_store_explicit(&slot->seq, pos + 1, memory_order_release);
+    sem_post(&r->ready);
+}
+
+static void *aggregator_thread_func(void *arg) {
+    ReplyRing *r = (ReplyRing *)arg;
+    for (;;) {
+        while (sem_wait(&r->ready) != 0 && errno == EINTR)
+            ;
+        ReplySlot *slot = &r->slots[r->tail & (REPLY_RING_SIZE - 1)];
+        // Семафор міг підняти виробник наступної комірки, поки
+        // виробник цієї ще копіює кадр
+        while (atomic_load_explicit(&slot->seq, memory_order_acquire) != r->tail + 1)
+            sched_yield();
+
+        int idx = slot->chunk_idx;
+        if (idx >= 0) {
+            const char *reply = slot->cached ? slot->cached : slot->data;
+            if (aggregate_map_reply(idx, reply) && slot->chunk_hash)
+                cache_remember(&g_cache, slot->chunk_hash, reply, slot->len,
+                               slot->cached != NULL);
+        }
+        atomic_store_explicit(&slot->seq, r->tail + REPLY_RING_SIZE, memory_order_release);
+        r->tail++;
+        if (idx < 0)
+            return NULL;
+    }
+}
+
+/*************************************************************
+ *  СПЕКУЛЯТИВНЕ ПЕРЕВИКОНАННЯ ЧАСТИН
+ *
+ *  Кожен запит map чекає на відповідь через zmq_poll. Якщо
+ *  дедлайн (--deadline) минув, частина потрапляє в чергу
+ *  g_spec, і потік, що вже виконав свої частини, надсилає її
+ *  своєму воркеру. Перша відповідь виграє: aggregate_map_reply
+ *  відкидає дублікати за індексом частини.
+ *************************************************************/
+#define DEFAULT_DEADLINE_MS 2000  // Дедлайн запиту map за замовчуванням
+#define SPEC_POLL_MS 50           // Крок опитування сокета
+#define MAX_BATCH 256             // Максимум частин в одному пакеті (як у воркера)
+#define BATCH_TARGET_MS 20        // Бажана тривалість одного пакетного запиту
+
+typedef struct SpecQueue {
+    int *items;                 // Індекси частин, що перевищили дедлайн
+    int head, count, capacity;
+    int primary_running;        // Потоки, що ще виконують свої частини
+    long speculated;            // Статистика: к-сть повторних запусків
+    pthread_mutex_t lock;       // Також захищає next/slow/exhausted потоків
+    pthread_cond_t cond;
+} SpecQueue;
+
+static SpecQueue g_spec = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER
+};
+static int g_deadline_ms = DEFAULT_DEADLINE_MS;
+
+static long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000L + ts.tv_nsec / 1000000;
+}
+
+static void spec_push(int idx) {
+    pthread_mutex_lock(&g_spec.lock);
+    if (g_spec.count == g_spec.capacity) {
+        int new_cap = g_spec.capacity ? g_spec.capacity * 2 : 64;
+        int *tmp = realloc(g_spec.items, new_cap * sizeof(int));
+        if (!tmp) {
+            pthread_mutex_unlock(&g_spec.lock);
+            return;
+        }
+        g_spec.items = tmp;
+        g_spec.capacity = new_cap;
+    }
+    g_spec.items[g_spec.count++] = idx;
+    pthread_cond_broadcast(&g_spec.cond);
+    pthread_mutex_unlock(&g_spec.lock);
+}
+
+// Бере наступну "свою" частину потоку td
+static int claim_chunk(WorkerThreadData *td) {
+    pthread_mutex_lock(&g_spec.lock);
+    int idx = td->next;
+    td->next += td->n_workers;
+    pthread_mutex_unlock(&g_spec.lock);
+    return idx;
+}
+
+static void set_slow(WorkerThreadData *td, int slow) {
+    pthread_mutex_lock(&g_spec.lock);
+    td->slow = slow;
+    pthread_cond_broadcast(&g_spec.cond);
+    pthread_mutex_unlock(&g_spec.lock);
+}
+
+// Своїх частин більше немає (вхід вичерпано)
+static void set_exhausted(WorkerThreadData *td) {
+    pthread_mutex_lock(&g_spec.lock);
+    td->exhausted = 1;
+    pthread_cond_broadcast(&g_spec.cond);
+    pthread_mutex_unlock(&g_spec.lock);
+}
+
+/*
+ * spec_abandon: зʼєднання потоку зламалося. Потік лишається
+ * "повільним" і не вичерпаним, тож його ще не надіслані частини
+ * забирають помічники (spec_next), а сам він більше не працює.
+ */
+static void spec_abandon(WorkerThreadData *td) {
+    pthread_mutex_lock(&g_spec.lock);
+    td->slow = 1;
+    g_spec.primary_running--;
+    pthread_cond_broadcast(&g_spec.cond);
+    pthread_mutex_unlock(&g_spec.lock);
+}
+
+// Потік виконав усі свої частини й переходить у режим помічника
+static void spec_primary_done(WorkerThreadData *td) {
+    pthread_mutex_lock(&g_spec.lock);
+    td->exhausted = 1;
+    g_spec.primary_running--;
+    pthread_cond_broadcast(&g_spec.cond);
+    pthread_mutex_unlock(&g_spec.lock);
+}
+
+/*
+ * spec_next: робота для потоку-помічника. Спершу частини з
+ * черги g_spec (копія запиту), потім ще не надіслані частини
+ * потоку, чий воркер зараз прострочив запит (*owner = цей потік).
+ * Повертає -1, коли роботи вже не буде (усі потоки завершили
+ * свої частини).
+ */
+static int spec_next(WorkerThreadData *td, WorkerThreadData **owner) {
+    int idx = -1;
+    *owner = NULL;
+    pthread_mutex_lock(&g_spec.lock);
+    for (;;) {
+        if (g_spec.head < g_spec.count) {
+            idx = g_spec.items[g_spec.head++];
+            g_spec.speculated++;
+            break;
+        }
+        for (int j = 0; j < td->n_workers && !*owner; j++) {
+            WorkerThreadData *o = &td->all[j];
+            if (o->slow && !o->exhausted) {
+                idx = o->next;
+                o->next += o->n_workers;
+                *owner = o;
+            }
+        }
+        if (*owner || g_spec.primary_running == 0) break;
+        pthread_cond_wait(&g_spec.cond, &g_spec.lock);
+    }
+    pthread_mutex_unlock(&g_spec.lock);
+    return idx;
+}
+
+/*************************************************************
+ *  МЕНЕДЖЕР ЗʼЄДНАНЬ
+ *
+ *  Одне REQ-зʼєднання на воркера на весь час роботи: воно
+ *  встановлюється на старті (з перевіркою готовності) і
+ *  використовується для map, reduce та "rip". Між фазами сокет
+ *  переходить від потоку map до головного потоку лише після
+ *  pthread_join, тож одночасно ним користується один потік.
+ *************************************************************/
+#define CONNECT_TIMEOUT_MS 5000   // Скільки чекати на готовність воркерів
+#define RIP_TIMEOUT_MS 2000       // Скільки чекати на відповіді "rip"
+static const char *const g_rip_msg[] = { "rip" };
+
+/*
+ * Аргумент-воркер: повний URI ("tcp://...", "ipc:///path"),
+ * "host:port" або просто порт. Простий порт означає воркера на
+ * цьому ж хості: спершу пробуємо його Unix-сокет (LOCAL_IPC_FMT,
+ * той самий, що в zmq_worker.c), а якщо там ніхто не слухає -
+ * "tcp://localhost:port".
+ */
+#define LOCAL_IPC_FMT "ipc://@rn-praxis3-worker-%s"
+
+typedef struct Connection {
+    const char *endpoint;       // Поточна адреса
+    char *fallback;             // Запасна адреса (TCP) або NULL
+    void *sock;
+    int ready;                  // 1, коли транспортне зʼєднання встановлено
+} Connection;
+
+/*
+ * resolve_endpoint: перетворює аргумент на адресу (і, можливо,
+ * запасну адресу). Повертає 0 або -1 для некоректного аргументу.
+ */
+static int resolve_endpoint(const char *arg, char **endpoint, char **fallback) {
+    char buf[256];
+    *fallback = NULL;
+    if (strstr(arg, "://")) {
+        *endpoint = strdup(arg);
+        return 0;
+    }
+    if (strchr(arg, ':')) {
+        snprintf(buf, sizeof(buf), "tcp://%s", arg);
+        *endpoint = strdup(buf);
+        return 0;
+    }
+    if (*arg == '\0' || strspn(arg, "0123456789") != strlen(arg))
+        return -1;
+    snprintf(buf, sizeof(buf), "tcp://localhost:%s", arg);
+#ifdef __linux__
+    *fallback = strdup(buf);
+    snprintf(buf, sizeof(buf), LOCAL_IPC_FMT, arg);
+#endif
+    *endpoint = strdup(buf);
+    return 0;
+}
+
+/*
+ * conn_open_all: підключає сокети до всіх воркерів і чекає,
+ * поки зʼєднання встановляться. Готовність видно з подій
+ * монітора сокета (ZMQ_EVENT_CONNECTED), тож протокол не
+ * отримує додаткових повідомлень. Якщо Unix-сокет відмовив
+ * (ZMQ_EVENT_CONNECT_RETRIED), сокет перепідключається на
+ * запасну TCP-адресу. Повертає 0 або -1.
+ */
+static int conn_open_all(Connection *conns, int n) {
+    int linger = 0;
+    int one = 1;
+    void **monitors = calloc(n, sizeof(void *));
+    for (int i = 0; i < n; i++) {
+        conns[i].ready = 0;
+        conns[i].sock = zmq_socket(g_zmq_context, ZMQ_REQ);
+        if (!conns[i].sock) {
+            perror("zmq_socket");
+            free(monitors);
+            return -1;
+        }
+        zmq_setsockopt(conns[i].sock, ZMQ_LINGER, &linger, sizeof(linger));
+        // Дозволяємо новий запит, не дочекавшись відповіді на покинутий
+        zmq_setsockopt(conns[i].sock, ZMQ_REQ_RELAXED, &one, sizeof(one));
+        zmq_setsockopt(conns[i].sock, ZMQ_REQ_CORRELATE, &one, sizeof(one));
+
+        // Монітор має існувати до zmq_connect, щоб не пропустити подію
+        char addr[64];
+        snprintf(addr, sizeof(addr), "inproc://conn-monitor-%d", i);
+        int events = ZMQ_EVENT_CONNECTED | ZMQ_EVENT_CONNECT_RETRIED;
+        if (zmq_socket_monitor(conns[i].sock, addr, events) == 0) {
+            monitors[i] = zmq_socket(g_zmq_context, ZMQ_PAIR);
+            zmq_connect(monitors[i], addr);
+        }
+        if (zmq_connect(conns[i].sock, conns[i].endpoint) != 0) {
+            perror("zmq_connect");
+            free(monitors);
+            return -1;
+        }
+    }
+
+    // Чекаємо на подію "зʼєднано" від кожного монітора
+    zmq_pollitem_t *items = malloc(n * sizeof(zmq_pollitem_t));
+    int pending = 0;
+    for (int i = 0; i < n; i++) {
+        if (monitors[i]) pending++;
+        else conns[i].ready = 1; // Без монітора готовність не перевіряємо
+        if (!monitors[i] && conns[i].fallback) {
+            // Без подій відмову Unix-сокета не видно: одразу TCP
+            zmq_disconnect(conns[i].sock, conns[i].endpoint);
+            zmq_connect(conns[i].sock, conns[i].fallback);
+            conns[i].endpoint = conns[i].fallback;
+        }
+    }
+    long deadline = now_ms() + CONNECT_TIMEOUT_MS;
+    while (pending > 0) {
+        int k = 0;
+        for (int i = 0; i < n; i++) {
+            if (conns[i].ready) continue;
+            items[k].socket = monitors[i];
+            items[k].fd = 0;
+            items[k].events = ZMQ_POLLIN;
+            items[k].revents = 0;
+            k++;
+        }
+        long left = deadline - now_ms();
+        if (left <= 0) break;
+        if (zmq_poll(items, k, left) < 0 && errno != EINTR) {
+            perror("zmq_poll connect");
+            break;
+        }
+        for (int i = 0, j = 0; i < n; i++) {
+            if (conns[i].ready) continue;
+            if (items[j++].revents & ZMQ_POLLIN) {
+                // Подія: кадр "номер (u16) + значення (u32)" і кадр з адресою
+                unsigned char ev[64];
+                int event = 0;
+                int more = 1;
+                size_t more_size = sizeof(more);
+                int rc = zmq_recv(monitors[i], ev, sizeof(ev), 0);
+                if (rc >= 2)
+                    event = ev[0] | (ev[1] << 8);
+                while (rc >= 0) {
+                    zmq_getsockopt(monitors[i], ZMQ_RCVMORE, &more, &more_size);
+                    if (!more) break;
+                    rc = zmq_recv(monitors[i], ev, sizeof(ev), 0);
+                }
+                if (event == ZMQ_EVENT_CONNECTED) {
+                    conns[i].ready = 1;
+                    pending--;
+                } else if (event == ZMQ_EVENT_CONNECT_RETRIED && conns[i].fallback
+                           && conns[i].endpoint != conns[i].fallback) {
+                    // Локального воркера немає: переходимо на TCP
+                    zmq_disconnect(conns[i].sock, conns[i].endpoint);
+                    zmq_connect(conns[i].sock, conns[i].fallback);
+                    conns[i].endpoint = conns[i].fallback;
+                }
+            }
+        }
+    }
+    free(items);
+
+    for (int i = 0; i < n; i++) {
+        if (monitors[i]) {
+            zmq_socket_monitor(conns[i].sock, NULL, 0);
+            zmq_close(monitors[i]);
+        }
+        if (!conns[i].ready)
+            fprintf(stderr, "Worker %s is not reachable yet, requests will wait\n",
+                    conns[i].endpoint);
+    }
+    free(monitors);
+    return 0;
+}
+
+/*
+ * conn_broadcast: надсилає повідомлення з n_frames кадрів усім
+ * воркерам одразу й чекає відповідей паралельно (а не по черзі),
+ * не довше за timeout_ms (-1 - без обмеження). Якщо expect не
+ * NULL, відповідь мусить починатися з нього. Повертає кількість
+ * воркерів без (правильної) відповіді.
+ */
+static int conn_broadcast(Connection *conns, int n, const char *const *frames,
+                          int n_frames, long timeout_ms, const char *expect) {
+    const char *msg = frames[0];
+    zmq_pollitem_t *items = malloc(n * sizeof(zmq_pollitem_t));
+    int *waiting = calloc(n, sizeof(int));
+    int failed = 0;
+    int pending = 0;
+    for (int i = 0; i < n; i++) {
+        int f = 0;
+        while (f < n_frames &&
+               zmq_send(conns[i].sock, frames[f], strlen(frames[f]) + 1,
+                        ZMQ_DONTWAIT | (f < n_frames - 1 ? ZMQ_SNDMORE : 0)) >= 0)
+            f++;
+        if (f == n_frames) {
+            waiting[i] = 1;
+            pending++;
+        } else {
+            fprintf(stderr, "Could not send %.3s to %s\n", msg, conns[i].endpoint);
+            failed++;
+        }
+    }
+
+    long deadline = now_ms() + timeout_ms;
+    while (pending > 0) {
+        int k = 0;
+        for (int i = 0; i < n; i++) {
+            if (!waiting[i]) continue;
+            items[k].socket = conns[i].sock;
+            items[k].fd = 0;
+            items[k].events = ZMQ_POLLIN;
+            items[k].revents = 0;
+            k++;
+        }
+        long left = (timeout_ms < 0) ? -1 : deadline - now_ms();
+        if (timeout_ms >= 0 && left <= 0) break;
+        if (zmq_poll(items, k, left) < 0 && errno != EINTR) {
+            perror("zmq_poll broadcast");
+            break;
+        }
+        for (int i = 0, j = 0; i < n; i++) {
+            if (!waiting[i]) continue;
+            if (items[j++].revents & ZMQ_POLLIN) {
+                char rbuf[MAX_MSG_SIZE];
+                int r = zmq_recv(conns[i].sock, rbuf, sizeof(rbuf) - 1, ZMQ_DONTWAIT);
+                if (r >= 0) {
+                    rbuf[r] = '\0';
+                    waiting[i] = 0;
+                    pending--;
+                    if (expect && strncmp(rbuf, expect, strlen(expect)) != 0) {
+                        fprintf(stderr, "Worker %s rejected %.3s\n", conns[i].endpoint, msg);
+                        failed++;
+                    }
+                }
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        if (waiting[i]) {
+            fprintf(stderr, "Worker %s did not acknowledge %.3s\n", conns[i].endpoint, msg);
+            failed++;
+        }
+    }
+    free(items);
+    free(waiting);
+    return failed;
+}
+
+static void conn_close_all(Connection *conns, int n) {
+    for (int i = 0; i < n; i++) {
+        if (conns[i].sock)
+            zmq_close(conns[i].sock);
+        free(conns[i].fallback);
+    }
+}
+
+/*
+ * send_job_spec: надсилає "cfg" + g_job_id + g_job_spec воркерам
+ * conns[0..n). Довгі налаштування розбиваються по пробілах на
+ * кадри до MAX_MSG_SIZE байт (багаточастинний "cfg"). Повертає
+ * к-сть воркерів, що не прийняли налаштування, або -1.
+ */
+static int send_job_spec(Connection *conns, int n) {
+    const char *frames[MAX_BATCH];
+    char *bufs[MAX_BATCH];
+    int n_frames = 0;
+    const char *p = g_job_spec;
+    int rc = -1;
+    while (*p || n_frames == 0) {
+        if (n_frames == MAX_BATCH) {
+            fprintf(stderr, "Word filters are too long\n");
+            goto out;
+        }
+        char *buf = malloc(MAX_MSG_SIZE);
+        if (!buf) goto out;
+        bufs[n_frames] = buf;
+        frames[n_frames++] = buf;
+        size_t len = 0;
+        size_t head = 0;
+        if (n_frames == 1) {
+            head = 3 + strlen(g_job_id);
+            memcpy(buf, "cfg", 3);
+            memcpy(buf + 3, g_job_id, head - 3);
+            len = head;
+        }
+        while (*p) {
+            size_t tlen = strcspn(p, " ");
+            if (len + tlen + 1 > MAX_MSG_SIZE - 1) break;
+            if (len > 3)
+                buf[len++] = ' ';
+            memcpy(buf + len, p, tlen);
+            len += tlen;
+            p += tlen;
+            while (*p == ' ') p++;
+        }
+        buf[len] = '\0';
+        if (*p && len <= head) {
+            fprintf(stderr, "Word filter entry is too long\n");
+            goto out;
+        }
+    }
+    rc = conn_broadcast(conns, n, frames, n_frames, -1, "cfg");
+out:
+    for (int i = 0; i < n_frames; i++)
+        free(bufs[i]);
+    return rc;
+}
+
+static void free_buffer(void *data, void *hint) {
+    (void)hint;
+    free(data);
+}
+
+/*
+ * send_ref: надсилає кадр data[0..len) без копіювання. Якщо
+ * owned, data - буфер із malloc, який звільнить ZeroMQ (або ця
+ * функція при помилці); інакше data має жити, доки закрито
+ * контекст ZeroMQ (як частини в ChunkArray).
+ */
+static int send_ref(void *sock, const char *data, size_t len, int owned, int flags) {
+    zmq_msg_t msg;
+    if (zmq_msg_init_data(&msg, (void *)data, len, owned ? free_buffer : NULL, NULL) != 0) {
+        if (owned) free((void *)data);
+        return -1;
+    }
+    if (zmq_msg_send(&msg, sock, flags) < 0) {
+        zmq_msg_close(&msg);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * send_map: надсилає одну частину класичним повідомленням
+ * "map + chunk" прямо з памʼяті частини (префікс "map" уже
+ * стоїть перед нею), а кілька - одним багаточастинним: кадр
+ * "map" і по кадру (<= 1500 байт) на кожну частину. Запити
+ * нетипової задачі завжди багаточастинні: перший кадр
+ * "map" + g_job_id.
+ */
+static int send_map(void *req, const char **chunks, int n) {
+    if (n == 1 && g_job_id[0] == '\0')
+        return send_ref(req, chunks[0] - CHUNK_HEADROOM,
+                        CHUNK_HEADROOM + strlen(chunks[0]) + 1, 0, 0);
+    char head[3 + sizeof(g_job_id)];
+    int hlen = snprintf(head, sizeof(head), "map%s", g_job_id);
+    if (zmq_send(req, head, (size_t)hlen, ZMQ_SNDMORE) < 0)
+        return -1;
+    for (int j = 0; j < n; j++) {
+        if (send_ref(req, chunks[j], strlen(chunks[j]) + 1, 0,
+                     (j < n - 1) ? ZMQ_SNDMORE : 0) < 0)
+            return -1;
+    }
+    return 0;
+}
+
+// Чи завершено вже всі частини запиту (іншими воркерами)
+static int all_done(const int *idxs, int n) {
+    for (int j = 0; j < n; j++) {
+        if (!chunk_is_done(idxs[j]))
+            return 0;
+    }
+    return 1;
+}
+
+// Частини idxs[from..n), ще не враховані, - у чергу g_spec
+static void spec_requeue(const int *idxs, int from, int n) {
+    for (int j = from; j < n; j++) {
+        if (!chunk_is_done(idxs[j]))
+            spec_push(idxs[j]);
+    }
+}
+
+/*
+ * map_request: надсилає n частин (див. send_map) і чекає
+ * відповіді з дедлайном. Якщо may_requeue, після дедлайну
+ * частини стають у чергу g_spec, а потік позначається повільним
+ * (помічники забирають його наступні частини). Якщо копії всіх
+ * частин тим часом завершили інші воркери, запит покидається
+ * (REQ_RELAXED + REQ_CORRELATE відкинуть запізнілу відповідь).
+ * Якщо зʼєднання зламалося або у відповіді менше кадрів, ніж
+ * частин, частини без відповіді стають у чергу g_spec. На
+ * UNKNOWN_JOB воркер ще раз отримує "cfg", і запит повторюється.
+ * Повертає 0, якщо всі частини враховано (тут або деінде), і -1
+ * при помилці зʼєднання.
+ */
+static int map_request(WorkerThreadData *td, void *req, const int *idxs,
+                       const char **chunks, int n, int may_requeue) {
+    int cfg_sent = 0;
+resend:
+    // Надсилаємо
+    if (send_map(req, chunks, n) != 0) {
+        perror("zmq_send map");
+        spec_requeue(idxs, 0, n);
+        return -1;
+    }
+
+    // Чекаємо відповіді
+    long start = now_ms();
+    int duplicated = !may_requeue;  // Чи можуть частини виконуватись ще десь
+    int overdue = 0;
+    char reply[MAX_MSG_SIZE];
+    int rsize = -1;
+    int failed = 0;
+    for (;;) {
+        zmq_pollitem_t item = { req, 0, ZMQ_POLLIN, 0 };
+        int rc = zmq_poll(&item, 1, SPEC_POLL_MS);
+        if (rc < 0) {
+            if (errno == EINTR) continue;
+            perror("zmq_poll map");
+            failed = 1;
+            break;
+        }
+        if (rc > 0) {
+            rsize = zmq_recv(req, reply, sizeof(reply) - 1, ZMQ_DONTWAIT);
+            if (rsize >= 0) break;
+            if (errno != EAGAIN) {
+                perror("zmq_recv map");
+                failed = 1;
+                break;
+            }
+            continue; // Запізніла відповідь на покинутий запит
+        }
+        if (duplicated && all_done(idxs, n))
+            break;
+        if (!overdue && g_deadline_ms > 0 && now_ms() - start >= g_deadline_ms) {
+            overdue = 1;
+            set_slow(td, 1);
+            if (!duplicated) {
+                for (int j = 0; j < n; j++)
+                    spec_push(idxs[j]);
+                duplicated = 1;
+            }
+        }
+    }
+    if (overdue && rsize >= 0)
+        set_slow(td, 0); // Воркер знову відповідає
+    if (failed) {
+        spec_requeue(idxs, 0, n);
+        return -1;
+    }
+    if (rsize < 0)
+        return 0; // Усі частини вже виконали інші воркери
+
+    if (rsize == (int)sizeof(UNKNOWN_JOB) && memcmp(reply, UNKNOWN_JOB, sizeof(UNKNOWN_JOB)) == 0) {
+        // Воркер не має налаштувань задачі (перезапущений або
+        // зайнятий іншою задачею)
+        if (g_job_cfg.sketch > 0 || g_job_cfg.distinct) {
+            // Разом із налаштуваннями втрачено й накопичене
+            fprintf(stderr, "Worker %s lost the job state\n", td->conn->endpoint);
+            g_state_lost = 1;
+        } else if (!cfg_sent && send_job_spec(td->conn, 1) == 0) {
+            cfg_sent = 1;
+            goto resend;
+        }
+        spec_requeue(idxs, 0, n);
+        return -1;
+    }
+
+    // По одному кадру відповіді на кожну частину; решта кадрів
+    // (усе повідомлення вже отримано) читається без очікування
+    int got = 0;
+    for (int j = 0; ; j++) {
+        if (j < n) {
+            got++;
+            // Розбір і агрегація - у потоці агрегації
+            uint64_t chunk_hash = g_cache.path
+                ? wc_hash64(chunks[j], strlen(chunks[j]), CACHE_SEED ^ g_job_tag) : 0;
+            reply_push(&g_replies, idxs[j], chunk_hash, reply, (size_t)rsize, NULL);
+        }
+        int more = 0;
+        size_t more_size = sizeof(more);
+        zmq_getsockopt(req, ZMQ_RCVMORE, &more, &more_size);
+        if (!more) break;
+        rsize = zmq_recv(req, reply, sizeof(reply) - 1, 0);
+        if (rsize < 0) {
+            perror("zmq_recv map");
+            failed = 1;
+            break;
+        }
+    }
+    if (got < n) {
+        fprintf(stderr, "map reply has %d of %d frames\n", got, n);
+        spec_requeue(idxs, got, n);
+        if (failed)
+            return -1;
+    }
+
+    // Підлаштовуємо розмір пакета під виміряний час запиту:
+    // швидкі запити - більший пакет, повільні - менший
+    if (td->batch_max > 1 && may_requeue) {
+        long rtt = now_ms() - start;
+        if (rtt * 2 < BATCH_TARGET_MS && td->batch < td->batch_max)
+            td->batch = (td->batch * 2 > td->batch_max) ? td->batch_max : td->batch * 2;
+        else if (rtt > BATCH_TARGET_MS && td->batch > 1)
+            td->batch /= 2;
+    }
+    return 0;
+}
+
+/*
+ * map_local: частини, що не потребують воркера: уже завершені
+ * (--resume) або знайдені в кеші. Повертає 1, якщо частину
+ * оброблено без запиту.
+ */
+static int map_local(int idx, const char *chunk) {
+    if (chunk_is_done(idx)) return 1; // уже враховано
+
+    // Якщо результат цієї частини вже є в кеші, воркер не потрібен
+    if (g_cache.path) {
+        uint32_t clen;
+        uint64_t chunk_hash = wc_hash64(chunk, strlen(chunk), CACHE_SEED ^ g_job_tag);
+        const char *cached = cache_lookup(&g_cache, chunk_hash, &clen);
+        if (cached) {
+            reply_push(&g_replies, idx, chunk_hash, NULL, clen - 1, cached);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Чи можна взяти наступну свою частину, не чекаючи на вхід
+static int next_chunk_ready(WorkerThreadData *td) {
+    pthread_mutex_lock(&g_spec.lock);
+    int idx = td->next;
+    pthread_mutex_unlock(&g_spec.lock);
+    ChunkArray *ca = td->chunk_array;
+    pthread_mutex_lock(&ca->lock);
+    int ready = idx < ca->count || ca->done;
+    pthread_mutex_unlock(&ca->lock);
+    return ready;
+}
+
+/*************************************************************
+ *  Потік для map-фази: Один потік на одного воркера.
+ *  Цей потік проходить по масиву частин, відбираючи "свої"
+ *  за індексом (round-robin або i + k*n), надсилає їх на worker,
+ *  і обробляє відповіді. Після цього допомагає з частинами
+ *  повільних воркерів.
+ *************************************************************/
+static void *map_thread_func(void *arg) {
+    WorkerThreadData *td = (WorkerThreadData *)arg;
+    affinity_pin_thread(&g_affinity, td->worker_index);
+
+    // Сокет цього воркера від менеджера зʼєднань
+    void *req = td->conn->sock;
+
+    // Проходимо усі chunks, але опрацьовуємо лише ті, які належать
+    // цьому worker_index (наприклад, chunk #0 -> worker0, #1->worker1, ...)
+    // Якщо частина ще не прочитана, chunks_wait чекає на неї.
+    // Кілька частин поспіль (до td->batch) ідуть одним пакетом.
+    int *idxs = malloc(td->batch_max * sizeof(int));
+    const char **batch = malloc(td->batch_max * sizeof(char *));
+    int end = 0;
+    while (!end) {
+        int n = 0;
+        while (n < td->batch) {
+            // Не затримуємо пакет, чекаючи на ще не прочитаний вхід
+            if (n > 0 && !next_chunk_ready(td)) break;
+            int i = claim_chunk(td);
+            char *chunk = chunks_wait(td->chunk_array, i);
+            if (!chunk) { // вхід вичерпано
+                end = 1;
+                break;
+            }
+            if (map_local(i, chunk)) continue;
+            idxs[n] = i;
+            batch[n] = chunk;
+            n++;
+        }
+        if (n > 0 && map_request(td, req, idxs, batch, n, 1) != 0)
+            break;  // Зʼєднання зламалося
+    }
+    free(idxs);
+    free(batch);
+    if (!end) {
+        // Решту своїх частин віддаємо помічникам
+        spec_abandon(td);
+        return NULL;
+    }
+
+    // Свої частини виконано: допомагаємо повільним воркерам
+    spec_primary_done(td);
+    WorkerThreadData *owner;
+    int idx;
+    while ((idx = spec_next(td, &owner)) >= 0) {
+        char *chunk = chunks_wait(td->chunk_array, idx);
+        if (!chunk) {
+            if (owner) set_exhausted(owner);
+            continue;
+        }
+        // Перехоплену частину ще ніхто не виконує, тож її можна
+        // знову поставити в чергу; копію з g_spec - ні
+        if (!map_local(idx, chunk)) {
+            const char *one_chunk = chunk;
+            if (map_request(td, req, &idx, &one_chunk, 1, owner != NULL) != 0)
+                break;  // Частину вже повернуто в чергу
+        }
+    }
+
+    return NULL;
+}
+
+/*************************************************************
+ *  build_reduce_payload: будує "red..." з global_omap;
+ *  повертає довжину без '\0'
+ *************************************************************/
+static size_t build_reduce_payload(char *out, size_t outsize) {
+    memcpy(out, "red", 3);
+    size_t pos = 3;
+
+    pthread_mutex_lock(&global_omap_lock);
+    OMNode *curr = global_omap->order_head;
+    OMNode *prev = NULL;
+    while (curr && pos < outsize - 1) {
+        int wlen = (int)strlen(WORD(curr->word));
+        if (pos + wlen >= outsize - 1)
+            break;
+        memcpy(out + pos, WORD(curr->word), wlen);
+        pos += wlen;
+
+        while (curr->count > 0 && pos < outsize - 1) {
+            out[pos++] = '1';
+            curr->count--;
+        }
+
+        if (curr->count == 0) {
+            uint32_t key = curr->word;
+            if (!prev) {
+                global_omap->order_head = curr->order_next;
+                curr = global_omap->order_head;
+            } else {
+                prev->order_next = curr->order_next;
+                curr = prev->order_next;
+            }
+            om_remove(global_omap, key);
+        } else {
+            prev = curr;
+            curr = curr->order_next;
+        }
+    }
+    pthread_mutex_unlock(&global_omap_lock);
+    out[pos] = '\0';
+    return pos;
+}
+
+/*************************************************************
+ *  parse_reduce_reply: розбирає "word<number>" і оновлює
+ *  глобальну фінальну HashMap
+ *************************************************************/
+static void parse_reduce_reply(const char *reply) {
+    int i = 0;
+    int n = (int)strlen(reply);
+    while (i < n) {
+        const char *word = reply + i;
+        int wpos = (int)wc_word_span(word, (size_t)(n - i));
+        i += wpos;
+        wpos = (int)wc_word_clip(word, (size_t)wpos);
+
+        char nbuf[64];
+        int np = 0;
+        while (i < n && isdigit((unsigned char)reply[i])) {
+            if (np < 63)
+                nbuf[np++] = reply[i];
+            i++;
+        }
+        nbuf[np] = '\0';
+
+        if (wpos > 0 && np > 0) {
+            int c = atoi(nbuf);
+            pthread_mutex_lock(&global_hash_lock);
+            hm_update(global_hash_map, intern_len(word, (size_t)wpos), c);
+            pthread_mutex_unlock(&global_hash_lock);
+        }
+    }
+}
+
+/*************************************************************
+ *  ПАРАЛЕЛЬНИЙ REDUCE (десяткові лічильники)
+ *
+ *  З g_job_cfg.decimal кожне слово надсилається один раз із
+ *  десятковою сумою ("red" + "word42..."), тож reduce можна
+ *  розділити: слова розбиваються між воркерами за зсувом в арені
+ *  (рядки вдруге не хешуються), і кожен воркер отримує свою
+ *  частину через власне зʼєднання (окремий потік на воркера).
+ *  Кожне слово потрапляє рівно до одного воркера, тож відповіді
+ *  просто додаються.
+ *************************************************************/
+
+// Воркер для слова: старші біти перемішаного зсуву
+static int word_part(uint32_t word, int n) {
+    uint64_t h = (uint64_t)word * 0x9E3779B97F4A7C15ULL;
+    return (int)((h >> 32) % (uint64_t)n);
+}
+
+typedef struct ReduceTask {
+    Connection *conn;
+    OMNode **nodes;             // Слова цього воркера
+    size_t count;
+    int failed;
+} ReduceTask;
+
+static void *reduce_thread_func(void *arg) {
+    ReduceTask *rt = arg;
+    char reply[MAX_MSG_SIZE];
+    size_t head = 3 + strlen(g_job_id);
+    size_t i = 0;
+    int cfg_sent = 0;
+    while (i < rt->count) {
+        size_t first = i;
+        // Буфер стає даними повідомлення, і його звільняє ZeroMQ
+        char *msg = malloc(MAX_MSG_SIZE);
+        if (!msg) {
+            fprintf(stderr, "Not enough memory\n");
+            rt->failed = 1;
+            return NULL;
+        }
+        memcpy(msg, "red", 3);
+        memcpy(msg + 3, g_job_id, head - 3);
+        size_t pos = head;
+        while (i < rt->count) {
+            char num[16];
+            int nlen = snprintf(num, sizeof(num), "%d", rt->nodes[i]->count);
+            const char *word = WORD(rt->nodes[i]->word);
+            size_t wlen = strlen(word);
+            if (pos + wlen + nlen >= MAX_MSG_SIZE)
+                break;
+            memcpy(msg + pos, word, wlen);
+            memcpy(msg + pos + wlen, num, nlen);
+            pos += wlen + nlen;
+            i++;
+        }
+        if (pos == head) {
+            // Слово не вміщується в повідомлення: рахуємо його тут
+            pthread_mutex_lock(&global_hash_lock);
+            hm_update(global_hash_map, rt->nodes[i]->word, rt->nodes[i]->count);
+            pthread_mutex_unlock(&global_hash_lock);
+            free(msg);
+            i++;
+            continue;
+        }
+        msg[pos] = '\0';
+        if (send_ref(rt->conn->sock, msg, pos + 1, 1, 0) == -1) {
+            perror("zmq_send reduce");
+            rt->failed = 1;
+            return NULL;
+        }
+        int r = zmq_recv(rt->conn->sock, reply, sizeof(reply) - 1, 0);
+        if (r < 0) {
+            perror("zmq_recv reduce");
+            rt->failed = 1;
+            return NULL;
+        }
+        if (r == (int)sizeof(UNKNOWN_JOB) && memcmp(reply, UNKNOWN_JOB, sizeof(UNKNOWN_JOB)) == 0) {
+            // Воркер не має налаштувань задачі: "cfg" і той самий запит
+            if (cfg_sent || send_job_spec(rt->conn, 1) != 0) {
+                fprintf(stderr, "Worker %s rejected the job\n", rt->conn->endpoint);
+                rt->failed = 1;
+                return NULL;
+            }
+            cfg_sent = 1;
+            i = first;
+            continue;
+        }
+        reply[r < (int)sizeof(reply) - 1 ? r : (int)sizeof(reply) - 1] = '\0';
+        parse_reduce_reply(reply);
+    }
+    return NULL;
+}
+
+/*
+ * reduce_partitioned: reduce усього global_omap на n воркерах.
+ * Після нього global_omap порожній. Повертає 0 або -1.
+ */
+static int reduce_partitioned(Connection *conns, int n) {
+    ReduceTask *tasks = calloc(n, sizeof(ReduceTask));
+    pthread_t *threads = malloc(n * sizeof(pthread_t));
+    OMNode **nodes = malloc((global_omap->size ? global_omap->size : 1) * sizeof(OMNode *));
+    int *part = malloc((global_omap->size ? global_omap->size : 1) * sizeof(int));
+    if (!tasks || !threads || !nodes || !part) {
+        fprintf(stderr, "Not enough memory\n");
+        free(tasks);
+        free(threads);
+        free(nodes);
+        free(part);
+        return -1;
+    }
+
+    // Розкладаємо вузли за воркерами (підрахунок, далі зсуви)
+    size_t total = 0;
+    for (OMNode *node = global_omap->order_head; node; node = node->order_next) {
+        part[total] = word_part(node->word, n);
+        tasks[part[total]].count++;
+        total++;
+    }
+    size_t offset = 0;
+    for (int w = 0; w < n; w++) {
+        tasks[w].conn = &conns[w];
+        tasks[w].nodes = nodes + offset;
+        offset += tasks[w].count;
+        tasks[w].count = 0;
+    }
+    size_t k = 0;
+    for (OMNode *node = global_omap->order_head; node; node = node->order_next, k++) {
+        ReduceTask *rt = &tasks[part[k]];
+        rt->nodes[rt->count++] = node;
+    }
+
+    int started = 0;
+    for (; started < n; started++) {
+        if (pthread_create(&threads[started], NULL, reduce_thread_func, &tasks[started]) != 0) {
+            perror("pthread_create reduce");
+            break;
+        }
+    }
+    // Воркери, для яких потік не запустився, обробляємо тут
+    for (int w = started; w < n; w++)
+        reduce_thread_func(&tasks[w]);
+    int rc = 0;
+    for (int w = 0; w < n; w++) {
+        if (w < started)
+            pthread_join(threads[w], NULL);
+        if (tasks[w].failed)
+            rc = -1;
+    }
+
+    om_free(global_omap);
+    global_omap = om_create();
+    free(tasks);
+    free(threads);
+    free(nodes);
+    free(part);
+    return rc;
+}
+
+/*************************************************************
+ *  Компаратор для фінального сортування
+ *************************************************************/
+static int cmp_final(const void *a, const void *b) {
+    const FPNode *fa = a;
+    const FPNode *fb = b;
+    if (fa->count > fb->count) return -1;
+    if (fa->count < fb->count) return 1;
+    return strcmp(WORD(fa->word), WORD(fb->word));
+}
+
+/*************************************************************
+ *  print_results: сортує фінальну мапу (частота спадає, далі
+ *  слово за абеткою) і друкує CSV; print_nodes - те саме для
+ *  готового масиву
+ *************************************************************/
+static void print_nodes(FPNode *arr, size_t total_words) {
+    qsort(arr, total_words, sizeof(FPNode), cmp_final);
+
+    printf("word,frequency\n");
+    for (size_t i = 0; i < total_words; i++) {
+        printf("%s,%d\n", WORD(arr[i].word), arr[i].count);
+    }
+}
+
+// Сортує масив фінальної мапи на місці: після друку мапа не потрібна
+static void print_results(void) {
+    print_nodes(global_hash_map->items, global_hash_map->size);
+}
+
+/*************************************************************
+ *  ВАЖКОВАГОВИКИ (--heavy K)
+ *
+ *  Воркери накопичують скетчі (Count-Min + Space-Saving) за всю
+ *  map-фазу, а дистриб'ютор замість reduce збирає їх командою
+ *  "sum" і зливає. Памʼять обох сторін не залежить від словника.
+ *  Повтор частини на іншому воркері (--deadline) порахував би її
+ *  двічі, тому в цьому режимі повторів немає.
+ *************************************************************/
+
+#define HEAVY_CANDIDATES 16       // Кандидатів Space-Saving на кожне виведене слово
+#define HEAVY_MIN_CANDIDATES 1024 // ...але не менше за це (похибка ~ total / кандидатів)
+
+static int g_heavy = 0;           // K з --heavy (0 - точний підрахунок)
+
+/*
+ * fetch_frames: надсилає команду cmd одному воркеру й склеює
+ * кадри відповіді. Повертає дані (звільняє викликач) або NULL.
+ */
+static unsigned char *fetch_frames(void *sock, const char *cmd, size_t *out_len) {
+    if (zmq_send(sock, cmd, strlen(cmd) + 1, 0) == -1) {
+        perror("zmq_send");
+        return NULL;
+    }
+    size_t len = 0, cap = 0;
+    unsigned char *data = NULL;
+    int ok = 1;
+    int more = 1;
+    while (more) {
+        unsigned char frame[MAX_MSG_SIZE];
+        int r = zmq_recv(sock, frame, sizeof(frame), 0);
+        if (r < 0) {
+            perror("zmq_recv");
+            free(data);
+            return NULL;
+        }
+        if (r > (int)sizeof(frame))
+            ok = 0;     // Кадр більший, ніж шле воркер
+        if (ok && len + r + 1 > cap) {
+            cap = (len + r + 1) * 2;
+            unsigned char *tmp = realloc(data, cap);
+            if (tmp) data = tmp;
+            else ok = 0;
+        }
+        if (ok) {
+            memcpy(data + len, frame, r);
+            len += r;
+        }
+        size_t more_size = sizeof(more);
+        zmq_getsockopt(sock, ZMQ_RCVMORE, &more, &more_size);
+    }
+    if (!ok || !data) {
+        free(data);
+        return NULL;
+    }
+    *out_len = len;
+    return data;
+}
 
-    // Формуємо endpoints
-    char **endpoints = malloc(n_workers * sizeof(char*));
-    for (int i = 0; i < n_workers; i++) {
-=======
+// fetch_sketch: скетч одного воркера ("sum")
+static WCSketch *fetch_sketch(void *sock) {
+    char cmd[3 + sizeof(g_job_id)];
+    snprintf(cmd, sizeof(cmd), "sum%s", g_job_id);
+    size_t len;
+    unsigned char *data = fetch_frames(sock, cmd, &len);
+    WCSketch *sk = data ? wc_sketch_parse(data, len) : NULL;
+    free(data);
+    return sk;
+}
 
-    int num_workers = argc - 2;
-    char **endpoints = malloc(num_workers * sizeof(char*));
-    for (int i = 0; i < num_workers; i++) {
->>>>>>> dc6bdc5 (Test handout)
-        char buf[64];
-        snprintf(buf, sizeof(buf), "tcp://localhost:%s", argv[i+2]);
-        endpoints[i] = strdup(buf);
+// Зливає скетчі всіх воркерів; NULL, якщо хоч один не отримано
+static WCSketch *collect_sketches(Connection *conns, int n) {
+    WCSketch *total = NULL;
+    for (int i = 0; i < n; i++) {
+        WCSketch *sk = fetch_sketch(conns[i].sock);
+        if (!sk || (total && wc_sketch_merge(total, sk) != 0)) {
+            fprintf(stderr, "Bad sketch from worker %s\n", conns[i].endpoint);
+            wc_sketch_free(sk);
+            wc_sketch_free(total);
+            return NULL;
+        }
+        if (!total)
+            total = sk;
+        else
+            wc_sketch_free(sk);
     }
+    return total;
+}
 
-<<<<<<< HEAD
-    // Створюємо ZeroMQ контекст
-=======
->>>>>>> dc6bdc5 (Test handout)
-    g_zmq_context = zmq_ctx_new();
-    if (!g_zmq_context) {
-        fprintf(stderr, "zmq_ctx_new error\n");
-        return 1;
+static int cmp_heavy(const void *a, const void *b) {
+    const WCHeavy *x = a;
+    const WCHeavy *y = b;
+    if (x->count != y->count)
+        return x->count > y->count ? -1 : 1;
+    return strcmp(x->word, y->word);
+}
+
+/*
+ * print_heavy: кандидати Space-Saving з оцінкою зверху
+ * (менша з Space-Saving і Count-Min) і похибкою: точна частота
+ * лежить у [frequency - error, frequency].
+ */
+static void print_heavy(const WCSketch *sk, int k) {
+    WCHeavy *items = malloc((size_t)k * sizeof(WCHeavy));
+    if (!items) {
+        fprintf(stderr, "Not enough memory\n");
+        return;
+    }
+    size_t n = wc_sketch_heavy(sk, items, (size_t)k);
+    for (size_t i = 0; i < n; i++) {
+        uint64_t lower = items[i].count - items[i].err;
+        uint64_t cm = wc_sketch_estimate(sk, items[i].word, strlen(items[i].word));
+        if (cm < items[i].count)
+            items[i].count = cm;
+        items[i].err = items[i].count - lower;
     }
+    qsort(items, n, sizeof(WCHeavy), cmp_heavy);
+
+    // Межа Count-Min: e / ширина * total з імовірністю 1 - e^-глибина
+    const double e = 2.718281828459045;
+    double fail = 1.0;
+    for (int i = 0; i < WC_CM_DEPTH; i++)
+        fail /= e;
+    uint64_t total = wc_sketch_total(sk);
+    fprintf(stderr, "heavy hitters: %llu words; count-min overestimates by at most "
+            "%.0f with probability %.3f\n", (unsigned long long)total,
+            e * (double)total / WC_CM_WIDTH, 1.0 - fail);
+    printf("word,frequency,error\n");
+    for (size_t i = 0; i < n; i++)
+        printf("%s,%llu,%llu\n", items[i].word, (unsigned long long)items[i].count,
+               (unsigned long long)items[i].err);
+    free(items);
+}
 
-<<<<<<< HEAD
-    // Читаємо файл
-    const char *filename = argv[1];
-    FILE *f = fopen(filename, "r");
-    if (!f) {
-        perror("fopen");
-        return 1;
+/*************************************************************
+ *  РІЗНІ СЛОВА (--distinct)
+ *
+ *  Воркери лише оновлюють регістри HyperLogLog (у map-фазі немає
+ *  відповідей зі словами), а дистриб'ютор забирає їх командою
+ *  "hll" і зливає поелементним максимумом. Злиття ідемпотентне,
+ *  тож повтори частин (--deadline) оцінку не змінюють.
+ *************************************************************/
+static WCHll g_distinct;                // Злиті регістри всіх воркерів
+
+// Повертає 0 або -1, якщо регістри якогось воркера не отримано
+static int collect_hll(Connection *conns, int n) {
+    char cmd[3 + sizeof(g_job_id)];
+    snprintf(cmd, sizeof(cmd), "hll%s", g_job_id);
+    for (int i = 0; i < n; i++) {
+        size_t len;
+        unsigned char *data = fetch_frames(conns[i].sock, cmd, &len);
+        if (!data || len != sizeof(WCHll)) {
+            fprintf(stderr, "Bad HyperLogLog registers from worker %s\n", conns[i].endpoint);
+            free(data);
+            return -1;
+        }
+        WCHll hll;
+        memcpy(hll.reg, data, sizeof(hll.reg));
+        wc_hll_merge(&g_distinct, &hll);
+        free(data);
+    }
+    return 0;
+}
+
+static void print_distinct(void) {
+    fprintf(stderr, "distinct: HyperLogLog estimate, standard error %.1f%%\n",
+            104.0 / sqrt((double)WC_HLL_REGISTERS));
+    printf("distinct\n%.0f\n", wc_hll_estimate(&g_distinct));
+}
+
+/*************************************************************
+ *  ЛОКАЛЬНИЙ РЕЖИМ (--local N)
+ *
+ *  Уся задача виконується в цьому процесі N потоками через
+ *  libwordcount, без ZeroMQ: кожен потік бере наступну частину,
+ *  рахує її слова у власному словнику, а наприкінці зливає
+ *  словник у global_hash_map.
+ *************************************************************/
+typedef struct LocalThreadData {
+    int index;
+    ChunkArray *chunk_array;
+    int *next;                  // Спільний лічильник частин
+    pthread_mutex_t *next_lock;
+    int failed;
+    int failed_chunk;           // Частина, на якій потік зупинився (-1: словник)
+    int err;                    // errno тієї помилки (0, якщо не системна)
+} LocalThreadData;
+
+static void *local_thread_func(void *arg) {
+    LocalThreadData *ld = arg;
+    // Спершу закріплюємо потік: словник створюється вже тут, тож
+    // його памʼять виділяється на вузлі NUMA цього потоку
+    affinity_pin_thread(&g_affinity, ld->index);
+    // Зерно арени: хеші слів переходять у фінальну мапу без перерахунку
+    WCMap *words = wc_map_create_seeded(g_words.seed);
+    WCHll *hll = g_job_cfg.distinct ? calloc(1, sizeof(WCHll)) : NULL;
+    if (!words || (g_job_cfg.distinct && !hll)) {
+        ld->failed = 1;
+        ld->failed_chunk = -1;
+        ld->err = ENOMEM;
+        wc_map_free(words);
+        free(hll);
+        return NULL;
+    }
+    for (;;) {
+        pthread_mutex_lock(ld->next_lock);
+        int idx = (*ld->next)++;
+        pthread_mutex_unlock(ld->next_lock);
+        const char *chunk = chunks_wait(ld->chunk_array, idx);
+        if (!chunk) break;
+        errno = 0;
+        long rc = hll ? wc_hll_add_chunk(hll, chunk, strlen(chunk), &g_job_cfg)
+                      : wc_count_chunk(words, chunk, strlen(chunk), &g_job_cfg);
+        if (rc < 0) {
+            ld->failed = 1;
+            ld->failed_chunk = idx;
+            ld->err = errno;
+            break;
+        }
     }
-    fseek(f, 0, SEEK_END);
-    long fsize = ftell(f);
-    fseek(f, 0, SEEK_SET);
-    char *file_content = malloc(fsize + 1);
-    if (!file_content) {
-        fclose(f);
+
+    pthread_mutex_lock(&global_hash_lock);
+    if (hll)
+        wc_hll_merge(&g_distinct, hll);
+    for (WCNode *node = words->order_head; node; node = node->order_next)
+        hm_update(global_hash_map,
+                  intern_hashed(node->word, node->len, node->hash), node->count);
+    pthread_mutex_unlock(&global_hash_lock);
+    wc_map_free(words);
+    free(hll);
+    return NULL;
+}
+
+/*
+ * run_local: читає вхід і рахує його n_threads потоками. Якщо
+ * потік не запустився, його частку виконує цей потік, коли вхід
+ * уже прочитано (як у reduce_partitioned). Повертає 0 або -1
+ * (помилка читання, памʼяті чи підрахунку частини).
+ */
+static int run_local(FILE *in, int n_threads) {
+    pthread_t *threads = malloc(n_threads * sizeof(pthread_t));
+    LocalThreadData *ld = malloc(n_threads * sizeof(LocalThreadData));
+    if (!threads || !ld) {
         fprintf(stderr, "Not enough memory\n");
-        return 1;
+        free(threads);
+        free(ld);
+        return -1;
     }
-    fread(file_content, 1, fsize, f);
-    file_content[fsize] = '\0';
-    fclose(f);
 
-    // Створюємо проміжну карту та фінальну
-    global_omap = om_create();
-    global_hash_map = hm_create();
+    ChunkArray chunk_array;
+    chunks_init(&chunk_array);
+    int next = 0;
+    pthread_mutex_t next_lock = PTHREAD_MUTEX_INITIALIZER;
+
+    int started = 0;
+    for (int i = 0; i < n_threads; i++) {
+        ld[i].index = i;
+        ld[i].chunk_array = &chunk_array;
+        ld[i].next = &next;
+        ld[i].next_lock = &next_lock;
+        ld[i].failed = 0;
+        ld[i].failed_chunk = -1;
+        ld[i].err = 0;
+    }
+    for (; started < n_threads; started++) {
+        if (pthread_create(&threads[started], NULL, local_thread_func, &ld[started]) != 0) {
+            perror("pthread_create local");
+            break;
+        }
+    }
 
-    // Спочатку розіб'ємо весь текст на chunks (не розриваючи слова)
-    // Але тепер не запускаємо потік на кожну частину; просто зберігаємо їх
-    size_t chunk_size = 1496;  // "map" + payload fits in 1500
-    char *ptr = file_content;
+    int rc = read_chunks(in, &chunk_array);
+    // Потоки, що не запустилися, виконуємо тут (вхід уже прочитано)
+    for (int i = started; i < n_threads; i++)
+        local_thread_func(&ld[i]);
+    for (int i = 0; i < n_threads; i++) {
+        if (i < started)
+            pthread_join(threads[i], NULL);
+        if (!ld[i].failed)
+            continue;
+        if (ld[i].failed_chunk < 0)
+            fprintf(stderr, "Thread %d: %s\n", i, strerror(ld[i].err));
+        else if (ld[i].err != 0)
+            fprintf(stderr, "Chunk %d was not counted: %s\n", ld[i].failed_chunk, strerror(ld[i].err));
+        else
+            fprintf(stderr, "Chunk %d was not counted\n", ld[i].failed_chunk);
+        rc = -1;
+    }
 
-    // Зберігатимемо всі знайдені частини у динамічному масиві
-    // Припустимо максимум ~65536 частин
-    char **chunk_array = malloc(sizeof(char*) * 65536);
-    int total_chunks = 0;
+    free(threads);
+    free(ld);
+    chunks_free(&chunk_array);
+    pthread_mutex_destroy(&next_lock);
+    return rc;
+}
 
-    while (*ptr) {
-        size_t len = strlen(ptr);
-        if (len == 0) break;
-        size_t actual = (len > chunk_size) ? chunk_size : len;
-        // Не розбивати слова
-        if (actual < len && ptr[actual] != ' ') {
-            while (actual > 0 && ptr[actual - 1] != ' ')
-                actual--;
+/*************************************************************
+ *  ФІЛЬТРИ СЛІВ (--stopwords, --min-len, --max-len, --prefix)
+ *
+ *  Фільтри стають частиною налаштувань задачі: воркери
+ *  застосовують їх у map до вставки в словник, тож відкинуті
+ *  слова не потрапляють ні в мережу, ні в агрегацію, ні у
+ *  фінальне сортування. Стоп-слова й префікси приводяться до
+ *  нормальної форми тим самим токенізатором, що й текст.
+ *************************************************************/
+typedef struct SpecBuf {
+    char *data;
+    size_t len, cap;
+    int failed;
+} SpecBuf;
+
+// Дописує " key" + word[0..len) до налаштувань
+static void spec_append(SpecBuf *sb, const char *key, const char *word, size_t len) {
+    size_t klen = strlen(key);
+    size_t need = sb->len + 1 + klen + len + 1;
+    if (need > sb->cap) {
+        size_t new_cap = sb->cap ? sb->cap * 2 : 256;
+        while (new_cap < need) new_cap *= 2;
+        char *tmp = realloc(sb->data, new_cap);
+        if (!tmp) {
+            sb->failed = 1;
+            return;
         }
-        chunk_array[total_chunks] = strndup(ptr, actual);
-        total_chunks++;
-        ptr += actual;
-        while (*ptr == ' ') ptr++; // skip spaces
+        sb->data = tmp;
+        sb->cap = new_cap;
     }
+    if (sb->len > 0)
+        sb->data[sb->len++] = ' ';
+    memcpy(sb->data + sb->len, key, klen);
+    memcpy(sb->data + sb->len + klen, word, len);
+    sb->len += klen + len;
+    sb->data[sb->len] = '\0';
+}
 
-    // Тепер запускаємо n потоків, по одному на кожен worker
-    pthread_t *threads = malloc(n_workers * sizeof(pthread_t));
-    WorkerThreadData *td_list = malloc(n_workers * sizeof(WorkerThreadData));
+static void spec_add_stop(const char *word, size_t len, void *ctx) {
+    spec_append(ctx, "stop=", word, len);
+}
 
-    for (int i = 0; i < n_workers; i++) {
-        td_list[i].worker_index = i;
-        td_list[i].endpoint = endpoints[i];
-        td_list[i].chunk_array = chunk_array;
-        td_list[i].total_chunks = total_chunks;
-        td_list[i].n_workers = n_workers;
-        pthread_create(&threads[i], NULL, map_thread_func, &td_list[i]);
+static void spec_add_prefix(const char *word, size_t len, void *ctx) {
+    spec_append(ctx, "prefix=", word, len);
+}
+
+// Читає файл цілком (з '\0' у кінці); NULL у разі помилки
+static char *read_file(const char *path, size_t *len) {
+    FILE *f = fopen(path, "r");
+    if (!f) return NULL;
+    char *data = NULL;
+    size_t cap = 0;
+    *len = 0;
+    for (;;) {
+        if (*len + READ_BUF_SIZE + 1 > cap) {
+            cap = cap ? cap * 2 : READ_BUF_SIZE + 1;
+            char *tmp = realloc(data, cap);
+            if (!tmp) {
+                free(data);
+                fclose(f);
+                return NULL;
+            }
+            data = tmp;
+        }
+        size_t n = fread(data + *len, 1, READ_BUF_SIZE, f);
+        *len += n;
+        if (n == 0) break;
+    }
+    int err = ferror(f);
+    fclose(f);
+    if (err) {
+        free(data);
+        return NULL;
     }
+    data[*len] = '\0';
+    return data;
+}
 
-    // Чекаємо завершення map-потоків
-    for (int i = 0; i < n_workers; i++) {
-        pthread_join(threads[i], NULL);
+/*
+ * build_job_spec: додає фільтри до g_job_cfg (прапорці вже
+ * встановлено з параметрів) і записує канонічний текст
+ * налаштувань у g_job_spec. Повертає 0 або -1.
+ */
+static int build_job_spec(const char *stop_path, int min_len, int max_len,
+                          const char *prefixes) {
+    SpecBuf sb = { NULL, 0, 0, 0 };
+    char base[64];
+    size_t base_len = wc_config_format(&g_job_cfg, base, sizeof(base));
+    spec_append(&sb, "", base, base_len);
+    char num[16];
+    if (min_len > 0) {
+        snprintf(num, sizeof(num), "%d", min_len);
+        spec_append(&sb, "min=", num, strlen(num));
+    }
+    if (max_len > 0) {
+        snprintf(num, sizeof(num), "%d", max_len);
+        spec_append(&sb, "max=", num, strlen(num));
+    }
+    if (prefixes)
+        wc_tokenize(prefixes, strlen(prefixes), &g_job_cfg, spec_add_prefix, &sb);
+    if (stop_path) {
+        size_t len;
+        char *words = read_file(stop_path, &len);
+        if (!words) {
+            perror(stop_path);
+            free(sb.data);
+            return -1;
+        }
+        wc_tokenize(words, len, &g_job_cfg, spec_add_stop, &sb);
+        free(words);
+    }
+    if (sb.failed || wc_config_parse(&g_job_cfg, sb.data) != 0) {
+        fprintf(stderr, "Cannot build word filters\n");
+        free(sb.data);
+        return -1;
+    }
+    free(sb.data);
+
+    // Канонічна форма (стоп-слова відсортовано, без повторів)
+    size_t len = wc_config_format(&g_job_cfg, NULL, 0);
+    g_job_spec = malloc(len + 1);
+    if (!g_job_spec) {
+        fprintf(stderr, "Not enough memory\n");
+        return -1;
+    }
+    wc_config_format(&g_job_cfg, g_job_spec, len + 1);
+    return 0;
+}
+
+/*************************************************************
+ *  MAIN
+ *************************************************************/
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] <file.txt|-> <worker1> [<worker2> ...]\n"
+            "       %s --local N [options] <file.txt|->\n"
+            "A worker is a port (same host, Unix socket if available),\n"
+            "host:port, or a ZeroMQ URI such as ipc:///tmp/w1.\n"
+            "Options:\n"
+            "  --stdin                    read text from stdin (same as file \"-\")\n"
+            "  --checkpoint FILE          periodically save map-phase progress to FILE\n"
+            "  --checkpoint-interval SEC  seconds between checkpoints (default %d)\n"
+            "  --resume                   continue from the checkpoint in FILE\n"
+            "  --cache FILE               reuse per-chunk map results stored in FILE\n"
+            "  --deadline MS              re-dispatch map requests slower than MS\n"
+            "                             to an idle worker (default %d, 0 = off)\n"
+            "  --batch N                  send up to N chunks per multipart map\n"
+            "                             request, adapted to round-trip time\n"
+            "                             (default 1 = no batching, max %d)\n"
+            "  --local N                  count in this process with N threads,\n"
+            "                             without ZeroMQ workers\n"
+            "  --cpu-list LIST            run on these CPUs (e.g. 0-3,8); map\n"
+            "                             threads are pinned round-robin\n"
+            "  --numa-node N              run on the CPUs of NUMA node N\n"
+            "  --utf8                     treat input as UTF-8: words are runs of\n"
+            "                             Unicode letters, case-folded\n"
+            "  --sorted-runs              workers return sorted runs that are\n"
+            "                             k-way merged instead of hashed+reduced\n"
+            "  --normalize                send only the words, lowercased and\n"
+            "                             space-separated, to fit more per chunk\n"
+            "  --stopwords FILE           drop the words listed in FILE\n"
+            "  --min-len N, --max-len N   drop words shorter/longer than N letters\n"
+            "  --prefix LIST              keep only words starting with one of the\n"
+            "                             comma-separated prefixes\n"
+            "                             (filters run in the workers' map step)\n"
+            "  --ngram N                  count sequences of N consecutive words\n"
+            "                             (1..%d; reduce is spread over all workers)\n"
+            "  --heavy K                  approximate mode: workers keep fixed-size\n"
+            "                             Count-Min + Space-Saving sketches; print\n"
+            "                             the top K words with error bounds\n"
+            "                             (disables --deadline)\n"
+            "  --distinct                 only estimate the number of distinct\n"
+            "                             words (HyperLogLog), with no reduce\n",
+            prog, prog, DEFAULT_CKPT_INTERVAL, DEFAULT_DEADLINE_MS, MAX_BATCH,
+            WC_MAX_NGRAM);
+}
+
+int main(int argc, char *argv[]) {
+    int use_stdin = 0;
+    const char *ckpt_path = NULL;
+    int ckpt_interval = DEFAULT_CKPT_INTERVAL;
+    int resume = 0;
+    int batch_max = 1;
+    int local_threads = 0;
+    const char *cpu_spec = NULL;
+    int numa_node = -1;
+    const char *stop_path = NULL;
+    const char *prefixes = NULL;
+    int min_len = 0, max_len = 0;
+    static const struct option long_opts[] = {
+        {"stdin", no_argument, NULL, 's'},
+        {"checkpoint", required_argument, NULL, 'c'},
+        {"checkpoint-interval", required_argument, NULL, 'i'},
+        {"resume", no_argument, NULL, 'r'},
+        {"cache", required_argument, NULL, 'C'},
+        {"deadline", required_argument, NULL, 'd'},
+        {"batch", required_argument, NULL, 'b'},
+        {"local", required_argument, NULL, 'l'},
+        {"cpu-list", required_argument, NULL, 'P'},
+        {"numa-node", required_argument, NULL, 'N'},
+        {"utf8", no_argument, NULL, 'u'},
+        {"sorted-runs", no_argument, NULL, 'S'},
+        {"normalize", no_argument, NULL, 'n'},
+        {"stopwords", required_argument, NULL, 'w'},
+        {"min-len", required_argument, NULL, 'm'},
+        {"max-len", required_argument, NULL, 'M'},
+        {"prefix", required_argument, NULL, 'p'},
+        {"ngram", required_argument, NULL, 'g'},
+        {"heavy", required_argument, NULL, 'H'},
+        {"distinct", no_argument, NULL, 'D'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 's':
+            use_stdin = 1;
+            break;
+        case 'c':
+            ckpt_path = optarg;
+            break;
+        case 'i':
+            ckpt_interval = atoi(optarg);
+            if (ckpt_interval <= 0) ckpt_interval = DEFAULT_CKPT_INTERVAL;
+            break;
+        case 'r':
+            resume = 1;
+            break;
+        case 'C':
+            cache_open(&g_cache, optarg);
+            break;
+        case 'd':
+            g_deadline_ms = atoi(optarg);
+            if (g_deadline_ms < 0) g_deadline_ms = 0;
+            break;
+        case 'b':
+            batch_max = atoi(optarg);
+            if (batch_max < 1) batch_max = 1;
+            if (batch_max > MAX_BATCH) batch_max = MAX_BATCH;
+            break;
+        case 'P':
+            cpu_spec = optarg;
+            break;
+        case 'N':
+            numa_node = atoi(optarg);
+            break;
+        case 'u':
+            g_job_cfg.utf8 = 1;
+            break;
+        case 'S':
+            g_job_cfg.sorted = 1;
+            g_sorted_runs = 1;
+            break;
+        case 'n':
+            g_normalize = 1;
+            break;
+        case 'w':
+            stop_path = optarg;
+            break;
+        case 'm':
+            min_len = atoi(optarg);
+            break;
+        case 'M':
+            max_len = atoi(optarg);
+            break;
+        case 'p':
+            prefixes = optarg;
+            break;
+        case 'g': {
+            int n = atoi(optarg);
+            if (n < 1 || n > WC_MAX_NGRAM) {
+                fprintf(stderr, "--ngram needs N from 1 to %d\n", WC_MAX_NGRAM);
+                return 1;
+            }
+            if (n > 1) {
+                g_job_cfg.ngram = n;
+                g_job_cfg.decimal = 1;
+            }
+            break;
+        }
+        case 'H':
+            g_heavy = atoi(optarg);
+            if (g_heavy < 1 || g_heavy > WC_SKETCH_MAX_K) {
+                fprintf(stderr, "--heavy needs K from 1 to %d\n", WC_SKETCH_MAX_K);
+                return 1;
+            }
+            // Запас кандидатів: слова з частотою > total / кандидатів не губляться
+            g_job_cfg.sketch = g_heavy * HEAVY_CANDIDATES;
+            if (g_job_cfg.sketch < HEAVY_MIN_CANDIDATES)
+                g_job_cfg.sketch = HEAVY_MIN_CANDIDATES;
+            if (g_job_cfg.sketch > WC_SKETCH_MAX_K)
+                g_job_cfg.sketch = WC_SKETCH_MAX_K;
+            break;
+        case 'D':
+            g_job_cfg.distinct = 1;
+            break;
+        case 'l':
+            local_threads = atoi(optarg);
+            if (local_threads < 1) {
+                fprintf(stderr, "--local needs a positive thread count\n");
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
     }
 
-    // Після map-фази виконуємо reduce: підключаємося до ПЕРШОГО воркера
-    void *reduce_sock = zmq_socket(g_zmq_context, ZMQ_REQ);
-    if (!reduce_sock) {
-        perror("zmq_socket reduce");
+    // Позиційні аргументи: [файл] і порти воркерів
+    int argi = optind;
+    const char *filename = "-";
+    if (!use_stdin && argi < argc)
+        filename = argv[argi++];
+    if ((argi >= argc) != (local_threads > 0)) {
+        usage(argv[0]);
         return 1;
     }
-    int linger = 0;
-    zmq_setsockopt(reduce_sock, ZMQ_LINGER, &linger, sizeof(linger));
-    if (zmq_connect(reduce_sock, endpoints[0]) != 0) {
-=======
-    const char *filename = argv[1];
-    FILE *fp = fopen(filename, "r");
-    if (!fp) {
-        perror("fopen");
+    if (resume && !ckpt_path) {
+        fprintf(stderr, "--resume requires --checkpoint FILE\n");
         return 1;
     }
-    fseek(fp, 0, SEEK_END);
-    long fsize = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-
-    char *filecontent = malloc(fsize + 1);
-    if (!filecontent) {
-        fprintf(stderr, "Not enough memory\n");
-        fclose(fp);
+    if (local_threads > 0 && (ckpt_path || g_cache.path || g_sorted_runs)) {
+        fprintf(stderr, "--local cannot be combined with --checkpoint, --cache or --sorted-runs\n");
+        return 1;
+    }
+    if (g_job_cfg.sketch > 0 &&
+        (local_threads > 0 || ckpt_path || g_cache.path || g_sorted_runs)) {
+        // Скетчі живуть у воркерах, а не в global_omap
+        fprintf(stderr, "--heavy cannot be combined with --local, --checkpoint, --cache or --sorted-runs\n");
+        return 1;
+    }
+    if (g_job_cfg.distinct && (ckpt_path || g_cache.path || g_sorted_runs || g_heavy)) {
+        // Регістри живуть у воркерах: частини з кешу чи контрольної точки їх обминули б
+        fprintf(stderr, "--distinct cannot be combined with --checkpoint, --cache, --sorted-runs or --heavy\n");
+        return 1;
+    }
+    if (g_job_cfg.sketch > 0)
+        g_deadline_ms = 0;  // Повтор частини потрапив би у скетч двічі
+    if (g_sorted_runs && ckpt_path) {
+        // Контрольна точка зберігає global_omap, а серії живуть поза нею
+        fprintf(stderr, "--sorted-runs cannot be combined with --checkpoint\n");
         return 1;
     }
-    fread(filecontent, 1, fsize, fp);
-    filecontent[fsize] = '\0';
-    fclose(fp);
+    int n_workers = argc - argi;
+
+    // Формуємо endpoints
+    char **endpoints = malloc(n_workers * sizeof(char*));
+    Connection *conns = calloc(n_workers, sizeof(Connection));
+    for (int i = 0; i < n_workers; i++) {
+        if (resolve_endpoint(argv[argi + i], &endpoints[i], &conns[i].fallback) != 0) {
+            fprintf(stderr, "Bad worker endpoint: %s\n", argv[argi + i]);
+            return 1;
+        }
+        conns[i].endpoint = endpoints[i];
+    }
 
-    // Стартуем потоки map (по строкам)
-    pthread_t threads[1024];
-    int thread_count = 0;
+    // Відбиток налаштувань задачі: кеш і контрольні точки іншого
+    // режиму токенізації чи інших фільтрів не підходять
+    if (build_job_spec(stop_path, min_len, max_len, prefixes) != 0)
+        return 1;
+    if (g_job_spec[0] != '\0')
+        g_job_tag = wc_hash64(g_job_spec, strlen(g_job_spec), CACHE_SEED);
+    // Нормалізація змінює частини (але не налаштування воркера)
+    if (g_normalize)
+        g_job_tag = mix64(g_job_tag, wc_hash64("normalize", 9, CACHE_SEED));
+
+    // Закріплюємо процес до створення потоків: вони успадкують
+    // маску, а потоки map і локальні потоки звузять її до свого CPU
+    if (affinity_from_options(cpu_spec, numa_node, &g_affinity) != 0)
+        return 1;
+    if (affinity_pin_process(&g_affinity) != 0)
+        return 1;
 
-    char *file_ptr = filecontent; // Pointer to track the current position in filecontent
-    size_t chunk_size = 1496;    // Maximum chunk size
-    while (*file_ptr) {
-        WorkerInfo *wi = malloc(sizeof(*wi));
+    // Відкриваємо вхід: "-" означає stdin (pipe), інакше звичайний файл
+    FILE *in = stdin;
+    if (strcmp(filename, "-") != 0) {
+        in = fopen(filename, "r");
+        if (!in) {
+            perror("fopen");
+            return 1;
+        }
+    }
 
-        // Choose a worker in round-robin fashion
-        static int worker_index = 0;
-        int widx = worker_index % num_workers;
-        worker_index++;
+    // Арена слів для проміжної та фінальної мап
+    if (arena_init(&g_words) != 0)
+        return 1;
+    intern_common();
+
+    // Номер задачі - випадковий (зерно арени), щоб задачі двох
+    // дистриб'юторів з однаковими налаштуваннями не змішувались
+    if (g_job_spec[0] != '\0')
+        snprintf(g_job_id, sizeof(g_job_id), "@%016llx",
+                 (unsigned long long)(g_job_tag ^ g_words.seed));
+
+    // Локальний режим: без воркерів і без ZeroMQ
+    if (local_threads > 0) {
+        global_hash_map = hm_create();
+        int rc = run_local(in, local_threads);
+        if (in != stdin)
+            fclose(in);
+        if (g_job_cfg.distinct)
+            print_distinct();
+        else
+            print_results();
+        hm_free(global_hash_map);
+        arena_free(&g_words);
+        free(endpoints);
+        free(conns);
+        cpu_list_free(&g_affinity);
+        wc_config_free(&g_job_cfg);
+        free(g_job_spec);
+        return rc == 0 ? 0 : 1;
+    }
 
-        wi->index = widx;
-        wi->endpoint = endpoints[widx];
+    // Створюємо ZeroMQ контекст
+    g_zmq_context = zmq_ctx_new();
+    if (!g_zmq_context) {
+        fprintf(stderr, "zmq_ctx_new error\n");
+        return 1;
+    }
 
-        // Extract up to 1497 characters
-        size_t len = strlen(file_ptr);
-        size_t actual_chunk_size = (len > chunk_size) ? chunk_size : len;
+    // Одне зʼєднання на воркера на всі фази
+    if (conn_open_all(conns, n_workers) != 0) {
+        conn_close_all(conns, n_workers);
+        zmq_ctx_destroy(g_zmq_context);
+        return 1;
+    }
 
-        // Ensure the chunk ends at a space if it's not the last part of the file
-        if (actual_chunk_size < len && file_ptr[actual_chunk_size] != ' ') {
-            while (actual_chunk_size > 0 && file_ptr[actual_chunk_size - 1] != ' ') {
-                actual_chunk_size--;
-            }
+    // Нетипові налаштування задачі передаємо всім воркерам до map-фази
+    // (з типовими команда не надсилається, протокол не змінюється)
+    if (g_job_spec[0] != '\0') {
+        if (send_job_spec(conns, n_workers) != 0) {
+            fprintf(stderr, "Workers do not support the requested job options\n");
+            conn_broadcast(conns, n_workers, g_rip_msg, 1, RIP_TIMEOUT_MS, NULL);
+            conn_close_all(conns, n_workers);
+            zmq_ctx_destroy(g_zmq_context);
+            return 1;
         }
+    }
 
-        // Create a new chunk with the extracted part
-        wi->chunk = strndup(file_ptr, actual_chunk_size);
-
-        // Update the file pointer to the next part of the file
-        file_ptr += actual_chunk_size;
+    // Створюємо проміжну карту та фінальну
+    global_omap = om_create();
+    global_hash_map = hm_create();
 
-        // Skip leading spaces to start at the next word
-        while (*file_ptr == ' ') {
-            file_ptr++;
+    // Відновлюємо прогрес map-фази з контрольної точки
+    if (resume) {
+        if (access(ckpt_path, F_OK) != 0) {
+            fprintf(stderr, "No checkpoint at %s, starting from scratch\n", ckpt_path);
+        } else if (checkpoint_load(ckpt_path) != 0) {
+            return 1;
         }
+    }
 
-        // Create the thread to process this chunk
-        pthread_create(&threads[thread_count], NULL, map_thread, wi);
-        thread_count++;
+    // Періодичні контрольні точки під час map-фази
+    CheckpointCtx ckpt = { .path = ckpt_path, .interval = ckpt_interval, .stop = 0 };
+    pthread_t ckpt_thread;
+    if (ckpt_path) {
+        pthread_mutex_init(&ckpt.lock, NULL);
+        pthread_cond_init(&ckpt.cond, NULL);
+        pthread_create(&ckpt_thread, NULL, checkpoint_thread_func, &ckpt);
     }
 
+    // Частини (chunks) додаються під час читання входу
+    ChunkArray chunk_array;
+    chunks_init(&chunk_array);
 
-    // Ждём завершения map-потоков
-    for (int i = 0; i < thread_count; i++) {
-        pthread_join(threads[i], NULL);
+    // Відповіді map розбирає окремий потік агрегації
+    if (reply_ring_init(&g_replies) != 0) {
+        perror("reply_ring_init");
+        return 1;
     }
+    pthread_t aggregator;
+    pthread_create(&aggregator, NULL, aggregator_thread_func, &g_replies);
 
+    // Запускаємо n потоків, по одному на кожен worker; вони
+    // обробляють частини, щойно ті зʼявляються
+    pthread_t *threads = malloc(n_workers * sizeof(pthread_t));
+    WorkerThreadData *td_list = malloc(n_workers * sizeof(WorkerThreadData));
+    g_spec.primary_running = n_workers;
 
-    // Выполняем reduce, используем воркер[0]
-    // void *reduce_socket = zmq_socket(g_zmq_context, ZMQ_REQ);
-    // if (!reduce_socket) {
-    //     perror("zmq_socket reduce");
-    //     return 1;
-    // }
-    // int linger = 0;
-    // zmq_setsockopt(reduce_socket, ZMQ_LINGER, &linger, sizeof(linger));
+    for (int i = 0; i < n_workers; i++) {
+        td_list[i].worker_index = i;
+        td_list[i].conn = &conns[i];
+        td_list[i].chunk_array = &chunk_array;
+        td_list[i].n_workers = n_workers;
+        td_list[i].all = td_list;
+        td_list[i].next = i;
+        td_list[i].slow = 0;
+        td_list[i].exhausted = 0;
+        td_list[i].batch = 1;
+        td_list[i].batch_max = batch_max;
+    }
+    for (int i = 0; i < n_workers; i++) {
+        pthread_create(&threads[i], NULL, map_thread_func, &td_list[i]);
+    }
 
-    // if (zmq_connect(reduce_socket, endpoints[0]) != 0) {
-    //     perror("zmq_connect reduce");
-    //     return 1;
-    // }
+    // Читаємо вхід і ріжемо його на частини паралельно з map-фазою
+    int read_rc = read_chunks(in, &chunk_array);
+    if (in != stdin)
+        fclose(in);
 
-    // char reduce_msg[MSG_SIZE];
+    // Чекаємо завершення map-потоків, потім - агрегації їхніх відповідей
+    for (int i = 0; i < n_workers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    reply_push(&g_replies, -1, 0, NULL, 0, NULL);
+    pthread_join(aggregator, NULL);
+    reply_ring_destroy(&g_replies);
+
+    if (g_spec.speculated > 0)
+        fprintf(stderr, "Re-dispatched %ld straggling chunks\n", g_spec.speculated);
+    free(g_spec.items);
+
+    // Частина без відповіді (усі воркери, що могли її взяти,
+    // недоступні) - неповний результат: не друкуємо його
+    int missing = 0;
+    for (int i = 0; i < chunk_array.count; i++)
+        missing += !chunk_is_done(i);
+    if (missing > 0) {
+        fprintf(stderr, "%d of %d chunks were not counted (workers failed)\n",
+                missing, chunk_array.count);
+        read_rc = -1;
+    }
+    if (g_state_lost)
+        read_rc = -1;
+
+    // Зупиняємо потік контрольних точок і фіксуємо завершену map-фазу
+    if (ckpt_path) {
+        pthread_mutex_lock(&ckpt.lock);
+        ckpt.stop = 1;
+        pthread_cond_signal(&ckpt.cond);
+        pthread_mutex_unlock(&ckpt.lock);
+        pthread_join(ckpt_thread, NULL);
+        pthread_mutex_destroy(&ckpt.lock);
+        pthread_cond_destroy(&ckpt.cond);
+        if (read_rc == 0)
+            checkpoint_save(ckpt_path);
+    }
 
-    // build_reduce_payload(reduce_msg, MSG_SIZE);
-    // zmq_send(reduce_socket, reduce_msg, strlen(reduce_msg), 0);
+    // Оновлюємо кеш результатами цього запуску
+    if (g_cache.path) {
+        fprintf(stderr, "cache: %ld hits, %ld misses\n", g_cache.hits, g_cache.misses);
+        if (read_rc == 0)
+            cache_save(&g_cache);
+        cache_close(&g_cache);
+    }
 
-    // char reduce_reply[MSG_SIZE];
-    // memset(reduce_reply, 0, sizeof(reduce_reply));
-    // int r = zmq_recv(reduce_socket, reduce_reply, MSG_SIZE - 1, 0);
-    // if (r > 0) {
-    //     reduce_reply[r] = '\0';
-    //     parse_reduce_reply(reduce_reply);
-    // }
+    // Режим серій: злиття замінює reduce на воркері
+    FinalList final = { NULL, 0, 0, 0 };
+    if (g_sorted_runs && runs_finish(&final) != 0) {
+        fprintf(stderr, "Not enough memory\n");
+        read_rc = -1;
+    }
 
-    // zmq_close(reduce_socket);
-    void *reduce_socket = zmq_socket(g_zmq_context, ZMQ_REQ);
-    if (!reduce_socket) {
-        perror("zmq_socket reduce");
-        return 1;
+    // Режим скетчів: зливаємо скетчі воркерів замість reduce
+    WCSketch *heavy = NULL;
+    if (g_job_cfg.sketch > 0 && !g_state_lost) {
+        heavy = collect_sketches(conns, n_workers);
+        if (!heavy)
+            read_rc = -1;
     }
 
-    int linger = 0;
-    zmq_setsockopt(reduce_socket, ZMQ_LINGER, &linger, sizeof(linger));
+    // Оцінка різних слів: лише злиття регістрів
+    if (g_job_cfg.distinct && (g_state_lost || collect_hll(conns, n_workers) != 0))
+        read_rc = -1;
 
-    if (zmq_connect(reduce_socket, endpoints[0]) != 0) {
->>>>>>> dc6bdc5 (Test handout)
-        perror("zmq_connect reduce");
-        return 1;
-    }
+    // Десяткові лічильники: reduce розподіляється між усіма воркерами
+    if (g_job_cfg.decimal && !g_sorted_runs && !g_job_cfg.sketch && !g_job_cfg.distinct &&
+        reduce_partitioned(conns, n_workers) != 0)
+        read_rc = -1;
+
+    // Інакше після map-фази виконуємо reduce на ПЕРШОМУ воркері, що
+    // відповідав до кінця (завислий воркер заблокував би reduce)
+    int reducer = 0;
+    while (reducer < n_workers - 1 && td_list[reducer].slow)
+        reducer++;
+    void *reduce_sock = conns[reducer].sock;
 
-<<<<<<< HEAD
-    char reduce_msg[MAX_MSG_SIZE];
-    while (1) {
+    while (!g_sorted_runs && !g_job_cfg.decimal && !g_job_cfg.sketch && !g_job_cfg.distinct) {
         pthread_mutex_lock(&global_omap_lock);
         int empty = (global_omap->order_head == NULL);
         pthread_mutex_unlock(&global_omap_lock);
         if (empty) break;
 
-        build_reduce_payload(reduce_msg, MAX_MSG_SIZE);
-        if (zmq_send(reduce_sock, reduce_msg, strlen(reduce_msg) + 1, 0) == -1) {
+        char *reduce_msg = malloc(MAX_MSG_SIZE);
+        if (!reduce_msg) {
+            fprintf(stderr, "Not enough memory\n");
+            break;
+        }
+        size_t rlen = build_reduce_payload(reduce_msg, MAX_MSG_SIZE);
+        if (send_ref(reduce_sock, reduce_msg, rlen + 1, 1, 0) == -1) {
             perror("zmq_send reduce");
             break;
         }
@@ -937,210 +3608,53 @@ int main(int argc, char *argv[])
             parse_reduce_reply(reduce_reply);
         }
     }
-    zmq_close(reduce_sock);
 
-    // Надсилаємо "rip" усім воркерам
-    for (int i = 0; i < n_workers; i++) {
-        void *s = zmq_socket(g_zmq_context, ZMQ_REQ);
-        if (!s) {
-            perror("rip zmq_socket");
-            continue;
-        }
-        zmq_setsockopt(s, ZMQ_LINGER, &linger, sizeof(linger));
-        if (zmq_connect(s, endpoints[i]) == 0) {
-            zmq_send(s, "rip", 4, 0);
-            char rbuf[MAX_MSG_SIZE];
-            zmq_recv(s, rbuf, MAX_MSG_SIZE - 1, 0); // just ignore content
-        }
-        zmq_close(s);
-    }
+    // Надсилаємо "rip" усім воркерам паралельно
+    conn_broadcast(conns, n_workers, g_rip_msg, 1, RIP_TIMEOUT_MS, NULL);
+    conn_close_all(conns, n_workers);
+    free(conns);
 
     // Звільняємо контекст
     zmq_ctx_destroy(g_zmq_context);
 
-    // Формуємо фінальний список для сортування
-    int total_words = 0;
-    for (int i = 0; i < HASH_SIZE; i++) {
-        FPNode *node = global_hash_map->buckets[i];
-        while (node) {
-            total_words++;
-            node = node->next;
-        }
-    }
-    FPNode **arr = malloc(total_words * sizeof(FPNode*));
-    int idx = 0;
-    for (int i = 0; i < HASH_SIZE; i++) {
-        FPNode *node = global_hash_map->buckets[i];
-        while (node) {
-            arr[idx++] = node;
-            node = node->next;
-        }
+    // Сортуємо та друкуємо результат (неповний - ні, див. вище)
+    if (missing > 0) {
+        // Контрольна точка лишається для --resume
+    } else if (g_job_cfg.distinct) {
+        if (read_rc == 0)
+            print_distinct();
+    } else if (g_job_cfg.sketch > 0) {
+        if (heavy)
+            print_heavy(heavy, g_heavy);
+        wc_sketch_free(heavy);
+    } else if (g_sorted_runs) {
+        print_nodes(final.items, (size_t)final.count);
+        free(final.items);
+    } else {
+        print_results();
     }
-    qsort(arr, total_words, sizeof(FPNode*), cmp_final);
 
-    printf("word,frequency\n");
-    for (int i = 0; i < total_words; i++) {
-        printf("%s,%d\n", arr[i]->word, arr[i]->count);
-    }
+    // Задачу завершено: контрольна точка більше не потрібна
+    if (ckpt_path && read_rc == 0)
+        unlink(ckpt_path);
 
     // Прибирання
-    free(arr);
     for (int i = 0; i < n_workers; i++) {
         free(endpoints[i]);
     }
     free(endpoints);
 
-    for (int i = 0; i < total_chunks; i++) {
-        free(chunk_array[i]);
-    }
-    free(chunk_array);
-    free(file_content);
+    chunks_free(&chunk_array);
     free(threads);
     free(td_list);
 
     om_free(global_omap);
     hm_free(global_hash_map);
-=======
-    char reduce_msg[MSG_SIZE];
-
-    while (1) {
-        pthread_mutex_lock(&g_lock);
-        if (g_map_results == NULL) {
-            pthread_mutex_unlock(&g_lock);
-            break; // Exit the loop when g_map_results is empty
-        }
-        pthread_mutex_unlock(&g_lock);
-
-        // Build the reduce payload
-        memset(reduce_msg, 0, sizeof(reduce_msg));
-        build_reduce_payload(reduce_msg, MSG_SIZE);
-        reduce_msg[MSG_SIZE - 1] = '\0';
-        // printf("Reduce message len: %zu\n", strlen(reduce_msg));
-        // Send the reduce message to the worker
-        if (zmq_send(reduce_socket, reduce_msg, strlen(reduce_msg)+1, 0) == -1) {
-            perror("zmq_send reduce");
-            break;
-        }
-
-        // Receive the reduce reply from the worker
-        char reduce_reply[MSG_SIZE];
-        memset(reduce_reply, 0, sizeof(reduce_reply));
-        int r = zmq_recv(reduce_socket, reduce_reply, MSG_SIZE - 1, 0);
-        if (r > 0) {
-            reduce_reply[r] = '\0';
-            parse_reduce_reply(reduce_reply);
-        } else if (r == -1) {
-            perror("zmq_recv reduce");
-            break;
-        }
-    }
-
-
-    zmq_close(reduce_socket);
-
-    // KILL THEM ALLL
-    for (int i = 0; i < num_workers; i++) {
-        fprintf(stderr, "Sending rip");
-        void *s = zmq_socket(g_zmq_context, ZMQ_REQ);
-        if (!s) {
-            perror("zmq_socket rip");
-            zmq_close(s);
-            zmq_ctx_destroy(g_zmq_context);
-            return 1;
-        }
-        zmq_setsockopt(s, ZMQ_LINGER, &linger, sizeof(linger));
-        if (zmq_connect(s, endpoints[i]) != 0) {
-            perror("zmq_connect rip");
-            zmq_close(s);
-            zmq_ctx_destroy(g_zmq_context);
-            return 1;
-        }
-
-        zmq_send(s, "rip\0", 4, 0);
-
-        char rbuf[MSG_SIZE];
-        int rr2 = zmq_recv(s, rbuf, MSG_SIZE - 1, 0);
-        if (rr2 > 0) {
-            rbuf[rr2] = '\0';
-            // ожидаем "rip"
-        }
-
-        zmq_close(s);
-
-    }
-
-    zmq_ctx_destroy(g_zmq_context);
-
-    // Собираем и сортируем результаты
-    int count_final = 0;
-    pthread_mutex_lock(&g_final_lock);
-    {
-        FinalPair *fp2 = g_final_list;
-        while (fp2) {
-            count_final++;
-            fp2 = fp2->next;
-        }
-    }
-    pthread_mutex_unlock(&g_final_lock);
-
-    FinalPair **arr = malloc(count_final * sizeof(FinalPair*));
-    pthread_mutex_lock(&g_final_lock);
-    {
-        FinalPair *fp2 = g_final_list;
-        int idx = 0;
-        while (fp2) {
-            arr[idx++] = fp2;
-            fp2 = fp2->next;
-        }
-    }
-    pthread_mutex_unlock(&g_final_lock);
-
-    qsort(arr, count_final, sizeof(FinalPair*), cmpfunc);
-    fprintf(stderr, "Output of %d words", count_final);
+    arena_free(&g_words);
+    free(g_done_bits);
+    cpu_list_free(&g_affinity);
+    wc_config_free(&g_job_cfg);
+    free(g_job_spec);
 
-    // Печатаем CSV
-    printf("word,frequency\n");
-    for (int i = 0; i < count_final; i++) {
-        printf("%s,%d\n", arr[i]->word, arr[i]->count);
-
-    }
-    fprintf(stderr, "Printed csv");
-    free(arr);
-
-
-    // for (int i = 0; i < num_workers; i++) {
-    //     void *s = zmq_socket(g_zmq_context, ZMQ_REQ);
-    //     if (!s) {
-    //         perror("zmq_socket rip");
-    //         return 1;
-    //     }
-    //     if (s) {
-
-    //         zmq_setsockopt(s, ZMQ_LINGER, &linger, sizeof(linger));
-    //         if (zmq_connect(s, endpoints[i]) == 0) {
-
-    //             zmq_send(s, "rip\0", 4, 0);
-
-    //             char rbuf[MSG_SIZE];
-    //             int rr2 = zmq_recv(s, rbuf, MSG_SIZE - 1, 0);
-    //             if (rr2 > 0) {
-    //                 rbuf[rr2] = '\0';
-    //                 // ожидаем "rip"
-    //             }
-    //         }
-    //         zmq_close(s);
-    //     }
-    // }
-
-
-
-    // Очистка памяти
-    for (int i = 0; i < num_workers; i++) {
-        free(endpoints[i]);
-    }
-    free(endpoints);
-    free(filecontent);
->>>>>>> dc6bdc5 (Test handout)
-
-    return 0;
+    return read_rc == 0 ? 0 : 1;
 }
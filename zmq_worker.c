@@ -4,14 +4,36 @@
  *
  *  Логіка воркера:
  *   - Запускається командою: ./zmq_worker <port1> [<port2> ...]
+ *     (замість порту можна передати "host:port" або повний
+ *     URI, напр. "ipc:///tmp/w1"). --cpu-list / --numa-node
+ *     закріплюють процес за вказаними CPU.
  *   - Привʼязується (bind) до сокета типу REP на кожному з
  *     переданих портів.
  *   - Приймає повідомлення з командами "map", "red" або "rip".
  *   - Для "map" і "red" виконує обробку даних за допомогою
- *     впорядкованого хеш-словника (Ordered HashMap) з
+ *     впорядкованого хеш-словника (Ordered HashMap, libwordcount) з
  *     підрахунком слів і збереженням порядку вставки, а потім
  *     формує рядок-відповідь.
  *   - Для "rip" відправляє "rip" і завершує свою роботу.
+ *   - "cfg" + налаштування (напр. "cfgutf8 min=3") змінює
+ *     токенізацію та фільтри слів для наступних "map" і
+ *     підтверджується відповіддю "cfg". Довгі налаштування
+ *     (списки стоп-слів) надходять кількома кадрами.
+ *   - Налаштування належать задачі: "cfg" несе її номер
+ *     ("cfg@<номер> ..."), і кожен запит задачі теж ("map@<номер>"
+ *     першим кадром пакета, "red@<номер>...", "sum@<номер>").
+ *     Запит без номера рахується з типовими налаштуваннями, а на
+ *     запит невідомої задачі воркер відповідає "cfg?", і
+ *     дистриб'ютор надсилає "cfg" знову.
+ *   - Пакетний "map": багаточастинне повідомлення, де перший
+ *     кадр "map", а кожен наступний - окрема частина тексту.
+ *     Відповідь містить по одному кадру результату на частину.
+ *   - З налаштуванням "sketch=K" "map" лише додає слова до
+ *     скетчу воркера (Count-Min + Space-Saving) і відповідає
+ *     порожнім рядком; "sum" повертає скетч у двійковій формі
+ *     (кадрами до MAX_MSG_SIZE) і починає новий.
+ *   - З налаштуванням "distinct" "map" лише оновлює регістри
+ *     HyperLogLog; "hll" повертає їх (кадрами) і обнуляє.
  *************************************************************/
 
 #include <stdio.h>    // Бібліотека вводу-виводу (printf, perror, тощо)
@@ -20,270 +42,393 @@
 #include <ctype.h>    // Функції для перевірки й перетворення символів (isalpha, tolower)
 #include <zmq.h>      // Бібліотека ZeroMQ (обмін повідомленнями)
 #include <unistd.h>   // Функції системи UNIX (close, sleep, тощо)
+#include <getopt.h>   // Розбір параметрів (--cpu-list, --numa-node)
+
+#include "wordcount.h" // Підрахунок слів (libwordcount)
+#include "affinity.h"  // Закріплення за CPU / вузлом NUMA
 
 #define MAX_MSG_SIZE 1500  // Максимальний розмір повідомлення (у байтах)
-#define HASH_SIZE 1024      // Кількість бакетів у нашому хеш-словнику
+#define MAX_BATCH 256       // Максимум частин у пакетному "map"
+
+#define JOB_ID_LEN 16        // Шістнадцяткових цифр у номері задачі
+#define UNKNOWN_JOB "cfg?"   // Відповідь на запит невідомої задачі
+
+// Налаштування задачі від команди "cfg" і її номер ("" - немає)
+static WCConfig g_cfg = WC_CONFIG_DEFAULT;
+static char g_job_id[JOB_ID_LEN + 1] = "";
+
+// Для запитів без номера задачі (за замовчуванням - ASCII)
+static const WCConfig g_default_cfg = WC_CONFIG_DEFAULT;
+
+// Налаштування поточного запиту: g_cfg або g_default_cfg
+static const WCConfig *g_req_cfg = &g_default_cfg;
+
+// Скетч частот задачі (лише з g_cfg.sketch > 0), створюється з першим "map"
+static WCSketch *g_sketch = NULL;
+
+// Регістри HyperLogLog задачі (лише з g_cfg.distinct)
+static WCHll g_hll;
+
+// Номери слів на весь час роботи воркера (спільні для map і red);
+// якщо не вдалося створити, ядра рахують звичайним словником
+static WCIntern *g_intern = NULL;
+
+static WCIntern *intern_table(void) {
+    if (!g_intern)
+        g_intern = wc_intern_create(WC_INTERN_MAX_WORDS);
+    return g_intern;
+}
 
 /*************************************************************
- *   ВПОРЯДКОВАНИЙ ХЕШ- СЛОВНИК (Ordered HashMap)
+ *  ЛОГІКА ВОРКЕРА
+ *
+ *  Підрахунок слів (токенізатор, впорядкований хеш-словник,
+ *  ядра map/reduce) живе в libwordcount (wordcount.h); воркер
+ *  лише приймає команди й надсилає відповіді.
  *************************************************************/
 
 /*
- * Кожен вузол (HashNode) зберігає:
- *  - key: слово (рядок)
- *  - count: частота (підрахунок) слова
- *  - next: вказівник на наступний вузол у поточному бакеті
- *  - order_next: вказівник на наступний вузол у
- *    ланцюжку порядку вставки
+ * map_chunk: "map" однієї частини text[0..len). У режимі скетчу
+ * слова йдуть у g_sketch, а відповідь порожня. Повертає довжину
+ * відповіді.
  */
-typedef struct HashNode {
-    char *key;                 // Слово
-    int count;                 // Частота зустрічання
-    struct HashNode *next;     // Вказівник на наступний у тому ж бакеті
-    struct HashNode *order_next; // Вказівник на наступний за порядком вставки
-} HashNode;
+static size_t map_chunk(const char *text, size_t len, char *res, size_t ressize) {
+    const WCConfig *cfg = g_req_cfg;
+    if (cfg->distinct) {
+        if (wc_hll_add_chunk(&g_hll, text, len, cfg) < 0)
+            fprintf(stderr, "Not enough memory\n");
+        res[0] = '\0';
+        return 0;
+    }
+    if (cfg->sketch <= 0)
+        return wc_map_kernel_intern(intern_table(), text, len, cfg, res, ressize);
+    if (!g_sketch)
+        g_sketch = wc_sketch_create((size_t)cfg->sketch);
+    if (!g_sketch || wc_sketch_add_chunk(g_sketch, text, len, cfg) < 0)
+        fprintf(stderr, "Not enough memory for the sketch\n");
+    res[0] = '\0';
+    return 0;
+}
 
-/*
- * Структура HashMap зберігає:
- *  - buckets: масив вказівників на бакети (розмір = HASH_SIZE)
- *  - order_head: початок списку за порядком вставки
- *  - order_tail: кінець списку за порядком вставки
- */
-typedef struct HashMap {
-    HashNode **buckets;        // Масив із HASH_SIZE бакетів
-    HashNode *order_head;      // Початок ланцюжка порядку вставки
-    HashNode *order_tail;      // Кінець ланцюжка порядку вставки
-} HashMap;
+static size_t reduce_chunk(const char *text, size_t len, char *res, size_t ressize) {
+    return wc_reduce_kernel_intern(intern_table(), text, len, g_req_cfg, res, ressize);
+}
 
 /*
- * hash_function: Алгоритм djb2 для хешування рядка.
- * Приймає const char* (рядок), повертає ціле значення.
- * Результат береться за модулем HASH_SIZE, щоб вийшов індекс бакета.
+ * frame_job: відділяє від payload номер задачі ("@" і JOB_ID_LEN
+ * цифр). Частина тексту й payload "red" з "@" не починаються
+ * (роздільники на початку частини пропускаються), тож запит без
+ * номера однозначний. Повертає 0 без номера, 1 для поточної
+ * задачі і -1 для задачі, налаштувань якої воркер не має.
  */
-unsigned int hash_function(const char *str) {
-    unsigned long hash = 5381;
-    int c;
-    // Перебираємо кожен символ у рядку і коригуємо хеш
-    while ((c = *str++))
-        hash = ((hash << 5) + hash) + c; // hash * 33 + c
-    return (unsigned int)(hash % HASH_SIZE);
+static int frame_job(const char **payload, size_t *len) {
+    const char *p = *payload;
+    if (*len < JOB_ID_LEN + 1 || p[0] != '@')
+        return 0;
+    *payload += JOB_ID_LEN + 1;
+    *len -= JOB_ID_LEN + 1;
+    if (g_job_id[0] == '\0' || memcmp(p + 1, g_job_id, JOB_ID_LEN) != 0)
+        return -1;
+    return 1;
 }
 
 /*
- * create_hashmap: Виділяє памʼять для HashMap,
- * ініціалізує масив бакетів і вказівники order_head/tail.
+ * frame_text: текст кадру після skip байтів команди - до першого
+ * '\0' і не довше за MAX_MSG_SIZE - 1 байт (як раніше з буфером
+ * zmq_recv). Дані лишаються в кадрі, нічого не копіюється.
  */
-HashMap *create_hashmap(void) {
-    HashMap *map = malloc(sizeof(HashMap));
-    if (!map) return NULL;  // Якщо malloc повернув NULL, завершуємо
-    map->buckets = calloc(HASH_SIZE, sizeof(HashNode *));
-    map->order_head = NULL;
-    map->order_tail = NULL;
-    return map;
+static size_t frame_text(zmq_msg_t *msg, size_t skip, const char **text) {
+    const char *data = zmq_msg_data(msg);
+    size_t size = zmq_msg_size(msg);
+    if (size > MAX_MSG_SIZE - 1)
+        size = MAX_MSG_SIZE - 1;
+    const char *nul = memchr(data, '\0', size);
+    if (nul)
+        size = (size_t)(nul - data);
+    if (skip > size)
+        skip = size;
+    *text = data + skip;
+    return size - skip;
 }
 
+// Ключ команди з перших трьох байтів кадру (коротший кадр - нулі)
+static int frame_command(zmq_msg_t *msg) {
+    unsigned char cmd[3] = { 0, 0, 0 };
+    size_t size = zmq_msg_size(msg);
+    memcpy(cmd, zmq_msg_data(msg), size < 3 ? size : 3);
+    return (cmd[0] << 16) | (cmd[1] << 8) | cmd[2];
+}
+
+static void free_reply(void *data, void *hint) {
+    (void)hint;
+    free(data);
+}
+
+typedef size_t (*kernel_fn)(const char *text, size_t len, char *out, size_t outsize);
+
 /*
- * hm_insert: вставляє слово (key) з певним count у хеш-словник.
- * Якщо слово вже є, збільшує його лічильник.
- * Якщо слова немає, створює новий вузол і додає його в бакет
- * і в кінець ланцюга вставки.
+ * send_result: ядро пише відповідь одразу в буфер на MAX_MSG_SIZE
+ * байт, який стає даними вихідного zmq_msg_t (zmq_msg_init_data)
+ * і звільняється ZeroMQ після відправлення - без копій і memset.
  */
-void hm_insert(HashMap *map, const char *key, int count) {
-    // Обчислюємо індекс бакета
-    unsigned int index = hash_function(key);
-    HashNode *node = map->buckets[index];
-
-    // Перевіряємо, чи існує слово вже
-    while (node) {
-        if (strcmp(node->key, key) == 0) {
-            // Якщо знайшли, збільшуємо лічильник
-            node->count += count;
-            return;
-        }
-        node = node->next;
+static void send_result(void *rep_sock, kernel_fn fn, const char *text, size_t len,
+                        int flags) {
+    char *out = malloc(MAX_MSG_SIZE);
+    if (!out) {
+        zmq_send(rep_sock, "", 1, flags);
+        return;
     }
-    // Якщо слово не знайдено, створюємо новий вузол
-    HashNode *new_node = malloc(sizeof(HashNode));
-    new_node->key = strdup(key); // Копіюємо рядок key
-    new_node->count = count;
-    // Вставляємо на початок бакета
-    new_node->next = map->buckets[index];
-    map->buckets[index] = new_node;
-    // Спочатку встановлюємо order_next у NULL
-    new_node->order_next = NULL;
-    // Додаємо у кінець ланцюжка вставки
-    if (map->order_tail) {
-        map->order_tail->order_next = new_node;
-        map->order_tail = new_node;
-    } else {
-        map->order_head = new_node;
-        map->order_tail = new_node;
+    size_t n = fn(text, len, out, MAX_MSG_SIZE);
+    zmq_msg_t reply;
+    if (zmq_msg_init_data(&reply, out, n + 1, free_reply, NULL) != 0) {
+        free(out);
+        zmq_send(rep_sock, "", 1, flags);
+        return;
+    }
+    if (zmq_msg_send(&reply, rep_sock, flags) < 0) {
+        perror("zmq_msg_send");
+        zmq_msg_close(&reply);
+    }
+}
+
+// Надсилає data[0..len) кадрами до MAX_MSG_SIZE байт
+static void send_frames(void *rep_sock, const unsigned char *data, size_t len) {
+    for (size_t off = 0; off < len; off += MAX_MSG_SIZE) {
+        size_t n = (len - off < MAX_MSG_SIZE) ? len - off : MAX_MSG_SIZE;
+        zmq_send(rep_sock, data + off, n, (off + n < len) ? ZMQ_SNDMORE : 0);
     }
 }
 
 /*
- * free_hashmap: видаляє всі вузли й звільняє памʼять,
- * виділену для хеш-словника.
+ * send_sketch: "sum" - скетч кадрами до MAX_MSG_SIZE байт.
+ * Надісланий скетч звільняється: наступний "map" почне новий.
  */
-void free_hashmap(HashMap *map) {
-    if (!map) return;
-    // Ітеруємося за order_head -> order_next
-    HashNode *node = map->order_head;
-    while (node) {
-        HashNode *tmp = node;
-        node = node->order_next;
-        free(tmp->key);  // Звільняємо рядок
-        free(tmp);       // Звільняємо сам вузол
+static void send_sketch(void *rep_sock) {
+    if (!g_sketch && g_cfg.sketch > 0)
+        g_sketch = wc_sketch_create((size_t)g_cfg.sketch);
+    if (!g_sketch) {
+        zmq_send(rep_sock, "", 0, 0);
+        return;
+    }
+    size_t len = wc_sketch_serialize(g_sketch, NULL, 0);
+    unsigned char *data = malloc(len);
+    if (!data) {
+        fprintf(stderr, "Not enough memory for the sketch\n");
+        zmq_send(rep_sock, "", 0, 0);
+        return;
     }
-    free(map->buckets); // Звільняємо масив бакетів
-    free(map);          // Звільняємо саму структуру мапи
+    wc_sketch_serialize(g_sketch, data, len);
+    send_frames(rep_sock, data, len);
+    free(data);
+    wc_sketch_free(g_sketch);
+    g_sketch = NULL;
 }
 
-/*************************************************************
- *  ЛОГІКА ВОРКЕРА
- *************************************************************/
-
 /*
- * map_function:
- *  - Приймає рядок (payload), де можуть бути різні символи.
- *  - Перетворює будь-які неалфавітні символи у пробіли.
- *  - Переводить усі літери в нижній регістр (tolower).
- *  - Розбиває на слова (strtok), для кожного слова додає "1"
- *    у лічильник в нашій тимчасовій HashMap (збережена послідовність).
- *  - Потім проходить по порядку вставки (order_head -> order_tail),
- *    формує вихідний рядок: "word111..."
- *    (записує слово + стільки '1', скільки count).
- *  - Повертає результат як C-рядок.
+ * handle_batch: обробляє пакетний запит, перший кадр якого
+ * (команду) вже прочитано. Спершу читає всі кадри запиту
+ * (REP не дозволяє відповідати раніше), потім надсилає по
+ * одному кадру результату на кожну частину. Частини
+ * обробляються прямо в отриманих кадрах.
  */
-static char *map_function(const char *payload) {
-    // Копіюємо payload, щоб його змінювати (strdup)
-    char *copy = strdup(payload);
-    // Замінюємо все, що не букви, на пробіли + робимо букви нижнього регістра
-    for (size_t i = 0; i < strlen(copy); i++) {
-        if (!isalpha((unsigned char)copy[i]))
-            copy[i] = ' ';
+static void handle_batch(void *rep_sock, int command_key, int job) {
+    zmq_msg_t frames[MAX_BATCH];
+    int n = 0;
+    int more = 1;
+    while (more) {
+        zmq_msg_t scratch;
+        zmq_msg_t *part = (n < MAX_BATCH) ? &frames[n] : &scratch;
+        zmq_msg_init(part);
+        if (zmq_msg_recv(part, rep_sock, 0) < 0) {
+            perror("zmq_recv batch");
+            zmq_msg_close(part);
+            break;
+        }
+        more = zmq_msg_more(part);
+        if (part == &scratch)
+            zmq_msg_close(part);    // Понад MAX_BATCH частин - відкидаємо
         else
-            copy[i] = (char)tolower((unsigned char)copy[i]);
+            n++;
     }
 
-    // Створюємо тимчасовий хеш-словник
-    HashMap *map = create_hashmap();
-    // Розбиваємо copy на токени (слова)
-    char *token = strtok(copy, " \t\r\n");
-    while (token) {
-        hm_insert(map, token, 1); // Кожне слово +1
-        token = strtok(NULL, " \t\r\n");
-    }
-
-    // Формуємо результат у статичному буфері result
-    static char result[MAX_MSG_SIZE];
-    memset(result, 0, sizeof(result));
-    int idx = 0;
-    HashNode *curr = map->order_head;
-    // Ідемо за порядком вставки
-    while (curr) {
-        int key_len = (int)strlen(curr->key);
-        // Перевіряємо, чи вистачить місця
-        if (idx + key_len >= MAX_MSG_SIZE - 1)
-            break;
-        // Копіюємо слово
-        memcpy(result + idx, curr->key, key_len);
-        idx += key_len;
-        // Додаємо count разів '1'
-        for (int j = 0; j < curr->count; j++) {
-            if (idx >= MAX_MSG_SIZE - 1)
-                break;
-            result[idx++] = '1';
+    if (job < 0) {
+        zmq_send(rep_sock, UNKNOWN_JOB, sizeof(UNKNOWN_JOB), 0);
+    } else if (command_key != ('m' << 16 | 'a' << 8 | 'p') || n == 0) {
+        // Пакетна форма підтримується лише для "map"
+        zmq_send(rep_sock, "", 0, 0);
+    } else {
+        for (int i = 0; i < n; i++) {
+            const char *text;
+            size_t len = frame_text(&frames[i], 0, &text);
+            send_result(rep_sock, map_chunk, text, len, (i < n - 1) ? ZMQ_SNDMORE : 0);
         }
-        curr = curr->order_next;
     }
-    // Страхуємо, щоб рядок завершувався '\0'
-    result[MAX_MSG_SIZE - 1] = '\0';
+    for (int i = 0; i < n; i++)
+        zmq_msg_close(&frames[i]);
+}
 
-    free(copy);
-    free_hashmap(map);
-    return result;
+// Нова задача: скетч і регістри попередньої не переносяться
+static void reset_job_state(void) {
+    wc_sketch_free(g_sketch);
+    g_sketch = NULL;
+    memset(&g_hll, 0, sizeof(g_hll));
 }
 
 /*
- * reduce_function:
- *  - Приймає рядок формату "word111word111..." (де '1'
- *    відображають кількість).
- *  - Утворює HashMap (з порядком вставки).
- *  - Розбирає слово (букви) + рахує кількість '1'
- *    (наприклад, якщо 2 '1', то count=2).
- *  - Потім створює результат: "word2word2..." (наприклад),
- *    де число після слова вказує суму '1'.
+ * apply_cfg: "@<номер> налаштування" - нова задача замінює
+ * попередню. Невідомі налаштування чи відсутній номер - порожня
+ * відповідь, і попередня задача лишається.
  */
-static char *reduce_function(const char *payload) {
-    // Створюємо тимчасовий хеш-словник
-    HashMap *map = create_hashmap();
-    int i = 0;
-    int n = (int)strlen(payload);
-    while (i < n) {
-        char word_buffer[256];
-        int word_pos = 0;
-        // Збираємо послідовність літер
-        while (i < n && isalpha((unsigned char)payload[i])) {
-            if (word_pos < 255)
-                word_buffer[word_pos++] = payload[i];
-            i++;
-        }
-        word_buffer[word_pos] = '\0';
+static void apply_cfg(void *rep_sock, const char *spec) {
+    int tagged = spec[0] == '@' && strspn(spec + 1, "0123456789abcdef") == JOB_ID_LEN;
+    if (tagged && wc_config_parse(&g_cfg, spec + 1 + JOB_ID_LEN) == 0) {
+        memcpy(g_job_id, spec + 1, JOB_ID_LEN);
+        g_job_id[JOB_ID_LEN] = '\0';
+        reset_job_state();
+        zmq_send(rep_sock, "cfg", 4, 0);
+    } else {
+        fprintf(stderr, "Unsupported job config: %.200s\n", spec);
+        zmq_send(rep_sock, "", 0, 0);
+    }
+}
 
-        // Лічимо '1'
-        int count = 0;
-        while (i < n && payload[i] == '1') {
-            count++;
-            i++;
+/*
+ * handle_cfg_frames: багаточастинний "cfg" - довгі налаштування
+ * (напр. список стоп-слів), які дистриб'ютор розбив на кадри
+ * по межах слів. Кадри склеюються через пробіл і
+ * розбираються як одне налаштування.
+ */
+static void handle_cfg_frames(void *rep_sock, const char *first, size_t len) {
+    size_t cap = len + MAX_MSG_SIZE + 1;
+    char *spec = malloc(cap);
+    int ok = spec != NULL;
+    if (ok) {
+        memcpy(spec, first, len);
+        spec[len] = '\0';
+    }
+    int more = 1;
+    size_t more_size = sizeof(more);
+    while (more) {
+        char buffer[MAX_MSG_SIZE];
+        int recv_size = zmq_recv(rep_sock, buffer, sizeof(buffer) - 1, 0);
+        if (recv_size < 0) {
+            perror("zmq_recv cfg");
+            break;
         }
-
-        // Якщо є слово + кількість, вставляємо в map
-        if (word_pos > 0 && count > 0) {
-            hm_insert(map, word_buffer, count);
+        if (recv_size > (int)sizeof(buffer) - 1)
+            recv_size = sizeof(buffer) - 1;
+        buffer[recv_size] = '\0';
+        if (ok && len + recv_size + 2 > cap) {
+            cap = (cap + recv_size + 2) * 2;
+            char *tmp = realloc(spec, cap);
+            if (tmp) spec = tmp;
+            else ok = 0;
+        }
+        if (ok) {
+            spec[len++] = ' ';
+            memcpy(spec + len, buffer, recv_size + 1);
+            len += strlen(buffer);
         }
+        zmq_getsockopt(rep_sock, ZMQ_RCVMORE, &more, &more_size);
     }
-
-    // Будуємо відповідь у статичному буфері
-    static char result[MAX_MSG_SIZE];
-    memset(result, 0, sizeof(result));
-    int pos = 0;
-    HashNode *curr = map->order_head;
-    while (curr) {
-        int key_len = (int)strlen(curr->key);
-        if (pos + key_len >= MAX_MSG_SIZE - 1)
-            break;
-        // Копіюємо слово
-        memcpy(result + pos, curr->key, key_len);
-        pos += key_len;
-        // Додаємо число (count)
-        char nbuffer[64];
-        snprintf(nbuffer, sizeof(nbuffer), "%d", curr->count);
-        int num_len = (int)strlen(nbuffer);
-        if (pos + num_len >= MAX_MSG_SIZE - 1)
-            break;
-        memcpy(result + pos, nbuffer, num_len);
-        pos += num_len;
-        curr = curr->order_next;
+    if (ok) {
+        apply_cfg(rep_sock, spec);
+    } else {
+        fprintf(stderr, "Not enough memory for job config\n");
+        zmq_send(rep_sock, "", 0, 0);
     }
-    // Закінчуємо рядок
-    result[MAX_MSG_SIZE - 1] = '\0';
+    free(spec);
+}
 
-    free_hashmap(map);
-    return result;
+/*************************************************************
+ *  ENDPOINTS
+ *
+ *  Аргумент воркера - повний URI ZeroMQ ("tcp://...",
+ *  "ipc:///path"), пара "host:port" або просто порт. Для
+ *  простого порту воркер, окрім TCP на всіх інтерфейсах, слухає ще й
+ *  абстрактний Unix-сокет LOCAL_IPC_FMT (лише Linux, файлів не
+ *  лишає): дистриб'ютор на тому ж хості підключається через
+ *  нього замість loopback TCP.
+ *************************************************************/
+#define LOCAL_IPC_FMT "ipc://@rn-praxis3-worker-%s"
+
+static int resolve_bind(const char *arg, char *end, size_t endsize,
+                        char *local, size_t localsize) {
+    local[0] = '\0';
+    if (strstr(arg, "://")) {
+        snprintf(end, endsize, "%s", arg);
+        return 0;
+    }
+    if (strchr(arg, ':')) {
+        snprintf(end, endsize, "tcp://%s", arg);
+        return 0;
+    }
+    for (const char *p = arg; *p; p++) {
+        if (!isdigit((unsigned char)*p))
+            return -1;
+    }
+    if (*arg == '\0')
+        return -1;
+    snprintf(end, endsize, "tcp://*:%s", arg);
+#ifdef __linux__
+    snprintf(local, localsize, LOCAL_IPC_FMT, arg);
+#else
+    (void)localsize;
+#endif
+    return 0;
 }
 
 /*************************************************************
  *  ГОЛОВНА ФУНКЦІЯ (MAIN) для ZeroMQ Worker
  *************************************************************/
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] <port|host:port|uri> [...]\n"
+            "Options:\n"
+            "  --cpu-list LIST   run only on these CPUs, e.g. 0-3,8\n"
+            "  --numa-node N     run only on the CPUs of NUMA node N\n",
+            prog);
+}
+
 int main(int argc, char *argv[]) {
-    // Перевірка аргументів: мусить бути принаймні 2
-    // (назва програми + 1 порт)
-    if (argc < 2) {
-        fprintf(stderr, "Usage: %s <port1> [<port2> ...]\n", argv[0]);
+    const char *cpu_spec = NULL;
+    int numa_node = -1;
+    static const struct option long_opts[] = {
+        {"cpu-list", required_argument, NULL, 'P'},
+        {"numa-node", required_argument, NULL, 'N'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'P':
+            cpu_spec = optarg;
+            break;
+        case 'N':
+            numa_node = atoi(optarg);
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    // Перевірка аргументів: мусить бути принаймні 1 порт
+    if (optind >= argc) {
+        usage(argv[0]);
         return 1;
     }
 
+    // Закріплюємо процес до створення потоків ZeroMQ, щоб вони
+    // (і памʼять, яку вони першими торкнуться) лишились на тих
+    // самих CPU / вузлі NUMA
+    CpuList cpus;
+    if (affinity_from_options(cpu_spec, numa_node, &cpus) != 0)
+        return 1;
+    if (affinity_pin_process(&cpus) != 0)
+        return 1;
+    cpu_list_free(&cpus);
+
     // Створюємо контекст ZeroMQ
     void *cont = zmq_ctx_new();
     if (!cont) {
@@ -307,77 +452,117 @@ int main(int argc, char *argv[]) {
     int rcvtime = 1000; // мс
     zmq_setsockopt(rep_sock, ZMQ_RCVTIMEO, &rcvtime, sizeof(rcvtime));
 
-    // Привʼязуємо сокет REP до кожного порта, переданого в argv
-    for (int i = 1; i < argc; i++) {
+    // Привʼязуємо сокет REP до кожного endpoint з argv
+    for (int i = optind; i < argc; i++) {
         char end[128];
-        snprintf(end, sizeof(end), "tcp://*:%s", argv[i]);
+        char local[128];
+        if (resolve_bind(argv[i], end, sizeof(end), local, sizeof(local)) != 0) {
+            fprintf(stderr, "Bad endpoint: %s\n", argv[i]);
+            continue;
+        }
         if (zmq_bind(rep_sock, end) != 0) {
             perror("zmq_bind");
         } else {
             printf("Worker bound to %s\n", end);
             //fflush(stdout); // За бажанням
         }
+        // Для дистриб'ютора на тому ж хості - ще й Unix-сокет
+        if (local[0] != '\0' && zmq_bind(rep_sock, local) == 0)
+            printf("Worker bound to %s\n", local);
     }
 
     /*
      * Основний цикл:
-     *  - Чекає на повідомлення (zmq_recv).
+     *  - Чекає на повідомлення (zmq_msg_recv) і обробляє кадр на
+     *    місці, без копіювання в проміжний буфер.
      *  - Перевіряє перші 3 символи, щоб визначити команду
-     *    (map / red / rip).
-     *  - Викликає відповідну функцію (map_function або reduce_function)
-     *    або завершує при rip.
+     *    (map / red / rip / ...).
+     *  - Відповіді map і red ядро пише прямо в буфер вихідного
+     *    повідомлення (send_result); при rip - завершує роботу.
      */
     while (1) {
-        char buffer[MAX_MSG_SIZE];
-        memset(buffer, 0, sizeof(buffer));
-        int recv_size = zmq_recv(rep_sock, buffer, sizeof(buffer) - 1, 0);
-        if (recv_size < 0) {
+        zmq_msg_t msg;
+        zmq_msg_init(&msg);
+        if (zmq_msg_recv(&msg, rep_sock, 0) < 0) {
             // Якщо таймаут або помилка, просто продовжуємо
             perror("zmq_recv");
+            zmq_msg_close(&msg);
             continue;
         }
-        // Закінчуємо отриманий рядок '\0'
-        buffer[recv_size] = '\0';
 
         // Генеруємо простий ключ із перших трьох символів (наприклад, "map")
-        int command_key = (buffer[0] << 16) | (buffer[1] << 8) | buffer[2];
-
-        // Відділяємо payload (рядок після перших 3 символів)
-        const char *payload = buffer + 3;
-
-        char reply[MAX_MSG_SIZE];
-        memset(reply, 0, sizeof(reply));
+        int command_key = frame_command(&msg);
+
+        // Відділяємо payload (текст після перших 3 символів)
+        const char *payload;
+        size_t len = frame_text(&msg, 3, &payload);
+
+        // Номер задачі: її налаштування; без номера - типові
+        int is_cfg = command_key == ('c' << 16 | 'f' << 8 | 'g');
+        int job = is_cfg ? 0 : frame_job(&payload, &len);
+        g_req_cfg = (job > 0) ? &g_cfg : &g_default_cfg;
+
+        // Багаточастинне повідомлення - пакет частин
+        if (zmq_msg_more(&msg)) {
+            if (is_cfg)
+                handle_cfg_frames(rep_sock, payload, len);
+            else
+                handle_batch(rep_sock, command_key, job);
+            zmq_msg_close(&msg);
+            continue;
+        }
 
-        if (command_key == ('m' << 16 | 'a' << 8 | 'p')) {
+        int quit = 0;
+        if (job < 0 || (job == 0 && (command_key == ('s' << 16 | 'u' << 8 | 'm') ||
+                                     command_key == ('h' << 16 | 'l' << 8 | 'l')))) {
+            // Налаштувань задачі немає (воркер перезапущено чи її
+            // замінила інша): дистриб'ютор надішле "cfg" знову
+            zmq_send(rep_sock, UNKNOWN_JOB, sizeof(UNKNOWN_JOB), 0);
+        }
+        else if (command_key == ('m' << 16 | 'a' << 8 | 'p')) {
             // "map"
-            char *res = map_function(payload);
-            strncpy(reply, res, MAX_MSG_SIZE - 1);
-            reply[MAX_MSG_SIZE - 1] = '\0';
-            zmq_send(rep_sock, reply, strlen(reply) + 1, 0);
+            send_result(rep_sock, map_chunk, payload, len, 0);
         }
         else if (command_key == ('r' << 16 | 'e' << 8 | 'd')) {
             // "red"
-            char *res = reduce_function(payload);
-            strncpy(reply, res, MAX_MSG_SIZE - 1);
-            reply[MAX_MSG_SIZE - 1] = '\0';
-            zmq_send(rep_sock, reply, strlen(reply) + 1, 0);
+            send_result(rep_sock, reduce_chunk, payload, len, 0);
+        }
+        else if (command_key == ('s' << 16 | 'u' << 8 | 'm')) {
+            // "sum": скетч, накопичений за map-фазу
+            send_sketch(rep_sock);
+        }
+        else if (command_key == ('h' << 16 | 'l' << 8 | 'l')) {
+            // "hll": регістри HyperLogLog; наступна задача - з нуля
+            send_frames(rep_sock, g_hll.reg, sizeof(g_hll.reg));
+            memset(&g_hll, 0, sizeof(g_hll));
+        }
+        else if (is_cfg) {
+            // "cfg": налаштування задачі (потрібен рядок із '\0')
+            char spec[MAX_MSG_SIZE];
+            memcpy(spec, payload, len);
+            spec[len] = '\0';
+            apply_cfg(rep_sock, spec);
         }
         else if (command_key == ('r' << 16 | 'i' << 8 | 'p')) {
             // "rip": завершуємо
-            strcpy(reply, "rip");
-            reply[MAX_MSG_SIZE - 1] = '\0';
-            zmq_send(rep_sock, reply, strlen(reply) + 1, 0);
+            zmq_send(rep_sock, "rip", 4, 0);
             printf("Worker received rip -> exiting\n");
             fflush(stdout);
-            break;
+            quit = 1;
         }
         else {
             // Невідома команда: шлемо порожню відповідь
             zmq_send(rep_sock, "", 0, 0);
         }
+        zmq_msg_close(&msg);
+        if (quit)
+            break;
     }
 
     // Закриваємо сокет та контекст
+    wc_sketch_free(g_sketch);
+    wc_intern_free(g_intern);
+    wc_config_free(&g_cfg);
     zmq_close(rep_sock);
     zmq_ctx_destroy(cont);
     printf("Worker done.\n");